@@ -22,24 +22,518 @@
 // programs.
 
 #include "WhileCFG.h"
+#include "WhileBitVector.h"
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <thread>
+#include <tuple>
 
 #pragma once
 
+// A dense mapping from symbolic registers to abstract values, indexed by the
+// register number. Registers mapped to the default value V() are considered
+// absent. The vector grows on writes only, its size is thus bounded by
+// WhileFunction::NumRegisters.
+template<typename V>
+struct WhileRegisterMap
+{
+  std::vector<V> Values;
+
+  unsigned int size() const
+  {
+    return Values.size();
+  }
+
+  bool contains(unsigned int idx) const
+  {
+    return idx < Values.size() && !(Values[idx] == V());
+  }
+
+  const V &operator[](unsigned int idx) const
+  {
+    static const V absent;
+    return idx < Values.size() ? Values[idx] : absent;
+  }
+
+  V &operator[](unsigned int idx)
+  {
+    if (Values.size() <= idx)
+      Values.resize(idx + 1);
+    return Values[idx];
+  }
+
+  void reserve(unsigned int n)
+  {
+    Values.reserve(n);
+  }
+
+  bool operator==(const WhileRegisterMap &o) const
+  {
+    unsigned int n = std::max(size(), o.size());
+    for(unsigned int idx = 0; idx < n; idx++)
+    {
+      if (!((*this)[idx] == o[idx]))
+        return false;
+    }
+    return true;
+  }
+
+  bool operator!=(const WhileRegisterMap &o) const
+  {
+    return !(*this == o);
+  }
+};
+
+// A mapping from the blocks or instructions (K) of a program to values of type
+// V, stored in a vector indexed by their Id. Lookups of absent keys return V().
+template<typename K, typename V>
+struct WhileIdMap
+{
+  std::vector<V> Values;
+  std::vector<bool> Present;
+  unsigned int Count = 0;
+
+  // Make room for n keys, i.e., WhileProgram::NumBlocks or NumInstrs.
+  void resize(unsigned int n)
+  {
+    if (Values.size() < n)
+    {
+      Values.resize(n);
+      Present.resize(n);
+    }
+  }
+
+  bool empty() const
+  {
+    return Count == 0;
+  }
+
+  bool contains(const K *k) const
+  {
+    return k->Id < Present.size() && Present[k->Id];
+  }
+
+  const V &read(const K *k) const
+  {
+    static const V absent = V();
+    return contains(k) ? Values[k->Id] : absent;
+  }
+
+  V &operator[](const K *k)
+  {
+    if (Values.size() <= k->Id)
+      resize(std::max<unsigned int>(k->Id + 1, 2 * Values.size()));
+
+    if (!Present[k->Id])
+    {
+      Present[k->Id] = true;
+      Count++;
+    }
+    return Values[k->Id];
+  }
+
+  // Move the value of k from o into this map, if k is present in o.
+  void take(const K *k, WhileIdMap &o)
+  {
+    if (o.contains(k))
+      (*this)[k] = std::move(o.Values[k->Id]);
+  }
+
+  void erase(const K *k)
+  {
+    if (contains(k))
+    {
+      Present[k->Id] = false;
+      Values[k->Id] = V();
+      Count--;
+    }
+  }
+};
+
+// Number the blocks of f in reverse postorder of a depth-first search from the
+// entry block, indexed by block index. Unreachable blocks are numbered last.
+// The search follows taken branches before fall-through edges, which places
+// the exit of a loop after the loop's body.
+//
+// If heads is given, it is set to indicate the loop heads of f, i.e., the
+// targets of back edges found by the search, indexed by block index.
+inline std::vector<unsigned int> reversePostOrder(const WhileFunction &f,
+                                             std::vector<bool> *heads = nullptr)
+{
+  unsigned int n = f.BlocksByIndex.size();
+  std::vector<unsigned int> order(n, n);
+  std::vector<const WhileBlock *> post;
+  post.reserve(n);
+
+  if (heads)
+    heads->assign(n, false);
+
+  // Blocks on the search path, with the kind of the next successor to follow,
+  // from WBRANCH_TAKEN down to WFALL_THROUGH.
+  std::vector<std::pair<const WhileBlock *, int>> stack;
+  std::vector<bool> visited(n), onStack(n);
+  if (n != 0)
+  {
+    visited[0] = onStack[0] = true;
+    stack.emplace_back(f.BlocksByIndex[0], WBRANCH_TAKEN);
+  }
+
+  while(!stack.empty())
+  {
+    auto &[bb, kind] = stack.back();
+    if (kind < WFALL_THROUGH)
+    {
+      post.emplace_back(bb);
+      onStack[bb->Index] = false;
+      stack.pop_back();
+      continue;
+    }
+
+    const WhileBlock *next = bb->Succ[(WhileSuccKind)kind--];
+    if (!next)
+      continue;
+
+    if (!visited[next->Index])
+    {
+      visited[next->Index] = onStack[next->Index] = true;
+      stack.emplace_back(next, WBRANCH_TAKEN);
+    }
+    else if (heads && onStack[next->Index])
+      (*heads)[next->Index] = true;
+  }
+
+  unsigned int rpo = 0;
+  for(auto bb = post.rbegin(); bb != post.rend(); bb++)
+    order[(*bb)->Index] = rpo++;
+
+  for(unsigned int idx = 0; idx < n; idx++)
+  {
+    if (!visited[idx])
+      order[idx] = rpo++;
+  }
+
+  return order;
+}
+
+// Number the functions of p in a topological order of the strongly connected
+// components of the call graph, callees before callers, indexed by function
+// index. The functions of a component are numbered consecutively.
+//
+// If recursive is given, it is set to indicate the functions that are part of a
+// cycle of the call graph, indexed by function index.
+inline std::vector<unsigned int> callGraphOrder(const WhileProgram &p,
+                                        std::vector<bool> *recursive = nullptr)
+{
+  unsigned int n = p.FunctionsByIndex.size();
+  std::vector<std::vector<unsigned int>> callees(n);
+  for(const WhileFunction *f : p.FunctionsByIndex)
+  {
+    for(const WhileInstr *cs : f->CallSites)
+      callees[cs->Block->Function->Index].emplace_back(f->Index);
+  }
+
+  if (recursive)
+    recursive->assign(n, false);
+
+  // Tarjan's algorithm, which completes a component only after all components
+  // reachable from it, i.e., callees first.
+  std::vector<unsigned int> order(n), number(n, n), low(n);
+  std::vector<bool> onStack(n);
+  std::vector<unsigned int> component;
+  std::vector<std::pair<unsigned int, unsigned int>> stack;
+  unsigned int count = 0, rank = 0;
+
+  auto visit = [&](unsigned int f) {
+    number[f] = low[f] = count++;
+    onStack[f] = true;
+    component.emplace_back(f);
+    stack.emplace_back(f, 0);
+  };
+
+  for(unsigned int root = 0; root < n; root++)
+  {
+    if (number[root] == n)
+      visit(root);
+
+    while(!stack.empty())
+    {
+      unsigned int f = stack.back().first;
+      unsigned int next = stack.back().second++;
+      if (next < callees[f].size())
+      {
+        unsigned int g = callees[f][next];
+        if (number[g] == n)
+          visit(g);
+        else if (onStack[g])
+          low[f] = std::min(low[f], number[g]);
+        continue;
+      }
+
+      stack.pop_back();
+      if (!stack.empty())
+      {
+        unsigned int caller = stack.back().first;
+        low[caller] = std::min(low[caller], low[f]);
+      }
+
+      if (low[f] == number[f])
+      {
+        auto first = std::find(component.begin(), component.end(), f);
+        bool cycle = component.end() - first > 1 ||
+          std::count(callees[f].begin(), callees[f].end(), f);
+
+        for(auto g = first; g != component.end(); g++)
+        {
+          order[*g] = rank++;
+          onStack[*g] = false;
+          if (recursive)
+            (*recursive)[*g] = cycle;
+        }
+        component.erase(first, component.end());
+      }
+    }
+  }
+
+  return order;
+}
+
+// Results kept by an analysis for queries after the fixed-point was reached:
+// - WCACHE_NONE: only the output of each block is kept, queries recompute the
+//   block's input by joining the outputs of its neighbors.
+// - WCACHE_BLOCKS: the input of each block is kept as well, queries only
+//   re-apply the transfer functions within the queried block.
+// - WCACHE_INSTRS: the state before and after each instruction is stored while
+//   blocks are processed, queries do not recompute anything. Blocks are then
+//   always processed one instruction at a time. Inter-procedural analyses
+//   update the outputs of call sites outside the processing of their blocks
+//   and fall back to WCACHE_BLOCKS.
+enum WhileResultCache
+{
+  WCACHE_NONE,
+  WCACHE_BLOCKS,
+  WCACHE_INSTRS
+};
+
+// Direction in which information is propagated through the CFG.
+enum WhileDirection
+{
+  WFORWARD,
+  WBACKWARD
+};
+
+// A worklist of blocks, processed in reverse postorder of their function's
+// CFG, such that blocks are usually visited after their predecessors. Backward
+// worklists use postorder instead, visiting blocks after their successors.
+// Blocks of different functions are processed in the order of the function
+// index, or the order given by FunctionOrder. The order of each function is
+// computed once, when the first of its blocks is added.
+struct WhileWorkList
+{
+  bool Backward;
+
+  // Reverse postorder number of every block and whether it is a loop head,
+  // indexed by function and block index.
+  std::vector<std::vector<unsigned int>> Order;
+  std::vector<std::vector<bool>> Heads;
+
+  // Order in which functions are processed, indexed by function index, e.g.,
+  // see callGraphOrder. The function index is used if empty.
+  std::vector<unsigned int> FunctionOrder;
+
+  // Blocks of every function indexed by their order, and whether they are in
+  // the worklist.
+  std::vector<std::vector<const WhileBlock *>> Blocks;
+  std::vector<std::vector<bool>> Queued;
+
+  // Blocks in the worklist as a min-heap of function order, block order, and
+  // function index.
+  typedef std::tuple<unsigned int, unsigned int, unsigned int> entry_t;
+  std::vector<entry_t> Heap;
+
+  explicit WhileWorkList(bool backward = false) : Backward(backward)
+  {
+  }
+
+  bool empty() const
+  {
+    return Heap.empty();
+  }
+
+  void clear()
+  {
+    for(const auto &[fkey, key, findex] : Heap)
+      Queued[findex][key] = false;
+    Heap.clear();
+  }
+
+  void emplace(const WhileBlock *bb)
+  {
+    const WhileFunction *f = bb->Function;
+    if (Order.size() <= f->Index)
+    {
+      Order.resize(f->Index + 1);
+      Heads.resize(f->Index + 1);
+      Blocks.resize(f->Index + 1);
+      Queued.resize(f->Index + 1);
+    }
+
+    std::vector<unsigned int> &order = Order[f->Index];
+    std::vector<const WhileBlock *> &blocks = Blocks[f->Index];
+    if (order.empty())
+    {
+      order = reversePostOrder(*f, &Heads[f->Index]);
+      blocks.resize(order.size());
+      Queued[f->Index].resize(order.size());
+      for(const WhileBlock *b : f->BlocksByIndex)
+        blocks[Backward ? order.size() - 1 - order[b->Index]
+                        : order[b->Index]] = b;
+    }
+
+    unsigned int key = order[bb->Index];
+    if (Backward)
+      key = order.size() - 1 - key;
+
+    if (Queued[f->Index][key])
+      return;
+    Queued[f->Index][key] = true;
+
+    unsigned int fkey = FunctionOrder.empty() ? f->Index
+                                              : FunctionOrder[f->Index];
+    Heap.emplace_back(fkey, key, f->Index);
+    std::push_heap(Heap.begin(), Heap.end(), std::greater<entry_t>());
+  }
+
+  const WhileBlock *pop()
+  {
+    std::pop_heap(Heap.begin(), Heap.end(), std::greater<entry_t>());
+    auto [fkey, key, findex] = Heap.back();
+    Heap.pop_back();
+    Queued[findex][key] = false;
+    return Blocks[findex][key];
+  }
+
+  // Whether bb is a loop head, bb has to be added to the worklist before.
+  bool isLoopHead(const WhileBlock *bb) const
+  {
+    return Heads[bb->Function->Index][bb->Index];
+  }
+};
+
+// Statistics on the fixed-point iteration of an analysis.
+struct WhileAnalysisStats
+{
+  // Number of blocks processed, in total and during narrowing.
+  unsigned long BlockVisits = 0;
+  unsigned long NarrowingVisits = 0;
+
+  // Largest number of times a single block was processed.
+  unsigned int MaxBlockVisits = 0;
+
+  // Add the statistics of another run, e.g., on other functions.
+  WhileAnalysisStats &operator+=(const WhileAnalysisStats &o)
+  {
+    BlockVisits += o.BlockVisits;
+    NarrowingVisits += o.NarrowingVisits;
+    MaxBlockVisits = std::max(MaxBlockVisits, o.MaxBlockVisits);
+    return *this;
+  }
+};
+
 // Values of the domain D have to supply:
 // - A default constructor (D a; must work)
 // - A copy constructor (D a; D b(a); must work)
 // - An assignment operator (D a; D b; a = b; must work)
 // - A comparison operator (D a; D b; a != b; must work)
 //
-template<typename D>
+// Analyses implement the in-place functions transferInPlace and joinInto, which
+// update a value without copying it. Analyses that return a new value from
+// transfer and join(inputs) instead derive from WhileByValueAnalysis, which
+// implements the in-place functions in terms of them. The framework only calls
+// the in-place functions, and join(inputs) with no inputs for blocks without
+// predecessors.
+//
+// Backward analyses (Dir == WBACKWARD) join the values of a block's successors,
+// apply the transfer functions of its instructions in reverse order, and store
+// the value at the block's beginning in BBOut. The transfer function then
+// computes the state before an instruction from the state after it.
+//
+template<typename D, WhileDirection Dir = WFORWARD>
 struct WhileAnalysisInterface
 {
-  std::set<const WhileBlock *> WorkList;
+  typedef D Domain;
 
-  std::map<const WhileBlock*, D> BBOut;
+  WhileWorkList WorkList = WhileWorkList(Dir == WBACKWARD);
 
-  virtual D transfer(const WhileInstr &i, const D input) = 0;
-  virtual D join(std::list<D> inputs) = 0;
+  WhileResultCache Cache = WCACHE_BLOCKS;
+
+  WhileIdMap<WhileBlock, D> BBOut;
+
+  // Joined input of each block, at its beginning, or its end for backward
+  // analyses (WCACHE_BLOCKS).
+  WhileIdMap<WhileBlock, D> BBIn;
+
+  // States of each block, indexed by instruction index, followed by the state
+  // after the block's last instruction (WCACHE_INSTRS, or filled on demand by
+  // resultBefore/resultAfter).
+  WhileIdMap<WhileBlock, std::vector<D>> States;
+
+  // Widening is applied to the inputs of loop heads, from their second visit
+  // on. Once a fixed-point is reached, the loop heads are processed again in a
+  // descending pass, where each of them narrows its previous input at most
+  // NarrowingSteps times.
+  bool Widening = false;
+  unsigned int NarrowingSteps = 1;
+
+  // Number of visits of each block, and of narrowing steps of loop heads.
+  WhileIdMap<WhileBlock, unsigned int> Visits;
+  WhileIdMap<WhileBlock, unsigned int> Narrowings;
+
+  WhileAnalysisStats Stats;
+
+  // Extrapolate value from the previous input of a loop head, such that
+  // repeated widening reaches a fixed-point in a bounded number of steps.
+  virtual void widen(D &value, const D &previous)
+  {
+  }
+
+  // Refine the previous input of a loop head using the new input value.
+  virtual void narrow(D &value, const D &previous)
+  {
+  }
+
+  // Whether the input of bb is widened, by default if bb is a loop head. bb has
+  // to be added to the worklist before.
+  virtual bool isWideningPoint(const WhileBlock *bb)
+  {
+    return WorkList.isLoopHead(bb);
+  }
+
+  virtual D transfer(const WhileInstr &i, const D input)
+  {
+    D result(input);
+    transferInPlace(i, result);
+    return result;
+  }
+
+  virtual D join(std::list<D> inputs)
+  {
+    if (inputs.empty())
+      return D();
+
+    D result(std::move(inputs.front()));
+    for(auto input = std::next(inputs.begin()); input != inputs.end(); input++)
+      joinInto(result, *input);
+
+    return result;
+  }
+
+  // Update value to the state after i.
+  virtual void transferInPlace(const WhileInstr &i, D &value) = 0;
+
+  // Join input into result, which holds the join of at least one other input.
+  virtual void joinInto(D &result, const D &input) = 0;
 
   virtual std::ostream &dump_first(std::ostream &s, const D &value) = 0;
   virtual std::ostream &dump_pre(std::ostream &s, const D &value) = 0;
@@ -50,38 +544,248 @@ struct WhileAnalysisInterface
     return s << "\n";
   }
 
-  virtual D transf(const WhileInstr &i, const D input)
+  virtual void transf(const WhileInstr &i, D &value)
+  {
+    transferInPlace(i, value);
+  }
+
+  // Update value from the state at the beginning of bb to the state at its end,
+  // or from its end to its beginning for backward analyses.
+  virtual void transferBlock(const WhileBlock *bb, D &value)
   {
-    return transfer(i, input);
+    if (Dir == WBACKWARD)
+    {
+      for(auto i = bb->Body.rbegin(); i != bb->Body.rend(); i++)
+        transf(*i, value);
+    }
+    else
+    {
+      for(const WhileInstr &i : bb->Body)
+        transf(i, value);
+    }
+  }
+
+  // Output of bb, or D() if bb was not processed yet.
+  const D &readBBOut(const WhileBlock *bb) const
+  {
+    return BBOut.read(bb);
+  }
+
+  // Allocate the per-block state of the analysis for program p.
+  virtual void resize(const WhileProgram &p)
+  {
+    BBOut.resize(p.NumBlocks);
+    if (Cache == WCACHE_BLOCKS || Widening)
+      BBIn.resize(p.NumBlocks);
+    States.resize(p.NumBlocks);
+    Visits.resize(p.NumBlocks);
+    if (Widening)
+      Narrowings.resize(p.NumBlocks);
+  }
+
+  // Move the state of the blocks of f from o, which analyzed f, see
+  // analyzeParallel.
+  void merge(WhileAnalysisInterface &o, const WhileFunction &f)
+  {
+    for(const WhileBlock &bb : f.Body)
+    {
+      BBOut.take(&bb, o.BBOut);
+      BBIn.take(&bb, o.BBIn);
+      States.take(&bb, o.States);
+      Visits.take(&bb, o.Visits);
+      Narrowings.take(&bb, o.Narrowings);
+    }
   }
 
+  // Join the values of the predecessors of bb, or of its successors for
+  // backward analyses.
   virtual D join(const WhileBlock *bb)
   {
-    std::list<D> bbIn;
-    for(const auto &[pred, kind] : bb->Pred)
-      bbIn.emplace_back(BBOut[pred]);
+    D result;
+    bool first = true;
+    auto joinBlock = [&](const WhileBlock *input) {
+      if (first)
+        result = readBBOut(input);
+      else
+        joinInto(result, readBBOut(input));
+      first = false;
+    };
 
-    return join(bbIn);
+    if (Dir == WBACKWARD)
+    {
+      for(const auto &[kind, succ] : bb->Succ)
+        joinBlock(succ);
+    }
+    else
+    {
+      for(const auto &[pred, kind] : bb->Pred)
+        joinBlock(pred);
+    }
+
+    if (first)
+      return join(std::list<D>());
+
+    return result;
+  }
+
+  const WhileBlock *readBBOperand(const WhileInstr &i, unsigned int idx) const
+  {
+    const WhileOperand &op = i.Ops[idx];
+    switch (op.Kind)
+    {
+      case WBLOCK:
+        if (op.ValueOrIndex < 0) return nullptr;
+        else return i.Block->Function->BlocksByIndex.at(op.ValueOrIndex);
+
+      case WFUNCTION:
+      case WFRAMEPOINTER:
+      case WREGISTER:
+      case WIMMEDIATE:
+      case WUNKNOWN:
+        assert("Operand is not a block.");
+    }
+    abort();
+  }
+
+  // Compute the states of bb from its joined input bbIn, see States.
+  void transferStates(const WhileBlock *bb, const D &bbIn,
+                      std::vector<D> &states)
+  {
+    unsigned int n = bb->Body.size();
+    states.resize(n + 1);
+
+    if (Dir == WBACKWARD)
+    {
+      states[n] = bbIn;
+      for(auto i = bb->Body.rbegin(); i != bb->Body.rend(); i++, n--)
+      {
+        states[n - 1] = states[n];
+        transf(*i, states[n - 1]);
+      }
+    }
+    else
+    {
+      states[0] = bbIn;
+      for(const WhileInstr &i : bb->Body)
+      {
+        states[i.Index + 1] = states[i.Index];
+        transf(i, states[i.Index + 1]);
+      }
+    }
+  }
+
+  // States of bb, from the cache if available, otherwise computed into states.
+  const std::vector<D> &blockStates(const WhileBlock *bb,
+                                    std::vector<D> &states)
+  {
+    if (States.contains(bb))
+      return States[bb];
+
+    if (BBIn.contains(bb))
+      transferStates(bb, BBIn[bb], states);
+    else
+      transferStates(bb, join(bb), states);
+
+    return states;
+  }
+
+  // State before and after instruction i, in program order. The states of i's
+  // block are computed on the first query and kept in States. Results are
+  // valid once the analysis terminated.
+  const D &resultBefore(const WhileInstr &i)
+  {
+    return cachedStates(i.Block)[i.Index];
+  }
+
+  const D &resultAfter(const WhileInstr &i)
+  {
+    return cachedStates(i.Block)[i.Index + 1];
+  }
+
+  const std::vector<D> &cachedStates(const WhileBlock *bb)
+  {
+    if (!States.contains(bb))
+    {
+      std::vector<D> states;
+      blockStates(bb, states);
+      States[bb] = std::move(states);
+    }
+    return States[bb];
   }
 
   void iterate()
+  {
+    std::vector<const WhileBlock *> heads;
+    propagate(false, heads);
+
+    if (Widening && !heads.empty())
+    {
+      for(const WhileBlock *bb : heads)
+        WorkList.emplace(bb);
+      propagate(true, heads);
+    }
+  }
+
+  // Process blocks until the worklist is empty. The loop heads visited for the
+  // first time are added to heads.
+  void propagate(bool narrowing, std::vector<const WhileBlock *> &heads)
   {
     while(!WorkList.empty())
     {
-      const WhileBlock *bb = *WorkList.begin();
-      WorkList.erase(WorkList.begin());
+      const WhileBlock *bb = WorkList.pop();
+
+      unsigned int &visits = Visits[bb];
+      Stats.BlockVisits++;
+      Stats.MaxBlockVisits = std::max(Stats.MaxBlockVisits, ++visits);
+      if (narrowing)
+        Stats.NarrowingVisits++;
 
       D bbIn(join(bb));
 
-      for(const WhileInstr &i : bb->Body)
-        bbIn = transf(i, bbIn);
+      if (Widening && isWideningPoint(bb))
+      {
+        if (visits == 1)
+          heads.emplace_back(bb);
+        else if (!narrowing)
+          widen(bbIn, BBIn[bb]);
+        else if (Narrowings[bb]++ < NarrowingSteps)
+          narrow(bbIn, BBIn[bb]);
+        else
+          bbIn = BBIn[bb];
+
+        BBIn[bb] = bbIn;
+      }
+
+      if (Cache == WCACHE_INSTRS)
+      {
+        std::vector<D> &states = States[bb];
+        transferStates(bb, bbIn, states);
+        bbIn = Dir == WBACKWARD ? states.front() : states.back();
+      }
+      else
+      {
+        if (Cache == WCACHE_BLOCKS)
+          BBIn[bb] = bbIn;
+        if (!States.empty())
+          States.erase(bb);
+
+        transferBlock(bb, bbIn);
+      }
 
       D &bbOut = BBOut[bb];
       if (bbIn != bbOut)
       {
-        bbOut = bbIn;
-        for(const auto &[kind, succ] : bb->Succ)
-          WorkList.emplace(succ);
+        bbOut = std::move(bbIn);
+        if (Dir == WBACKWARD)
+        {
+          for(const auto &[pred, kind] : bb->Pred)
+            WorkList.emplace(pred);
+        }
+        else
+        {
+          for(const auto &[kind, succ] : bb->Succ)
+            WorkList.emplace(succ);
+        }
       }
     }
   }
@@ -93,20 +797,20 @@ struct WhileAnalysisInterface
       f.dumphead(s);
       dump_entry(s, f);
 
+      std::vector<D> scratch;
       for(const WhileBlock &bb : f.Body)
       {
-        D bbIn(join(&bb));
+        const std::vector<D> &states = blockStates(&bb, scratch);
 
         bb.dumphead(s) << "\n";
 
-        dump_first(s, bbIn);
+        dump_first(s, states[0]);
         for (const WhileInstr &i : bb.Body)
         {
-          dump_pre(s, bbIn);
+          dump_pre(s, states[i.Index]);
           s << std::setw(4) << i.Index << ": ";
           i.dump(s) << "\n";
-          bbIn = transf(i, bbIn);
-          dump_post(s, bbIn);
+          dump_post(s, states[i.Index + 1]);
         }
       }
     }
@@ -115,11 +819,35 @@ struct WhileAnalysisInterface
   }
 };
 
-template<typename D>
-struct WhileDataFlowAnalysis : public WhileAnalysisInterface<D>
+// Base of analyses that implement transfer and join(inputs), returning a new
+// value, instead of the in-place functions, e.g.,
+// WhileByValueAnalysis<WhileDataFlowAnalysis<D>>.
+template<typename Base>
+struct WhileByValueAnalysis : public Base
 {
-  using WhileAnalysisInterface<D>::WorkList;
-  using WhileAnalysisInterface<D>::iterate;
+  typedef typename Base::Domain D;
+  using Base::join;
+
+  virtual D transfer(const WhileInstr &i, const D input) = 0;
+  virtual D join(std::list<D> inputs) = 0;
+
+  void transferInPlace(const WhileInstr &i, D &value) override
+  {
+    value = transfer(i, value);
+  }
+
+  void joinInto(D &result, const D &input) override
+  {
+    result = join(std::list<D>{result, input});
+  }
+};
+
+template<typename D, WhileDirection Dir = WFORWARD>
+struct WhileDataFlowAnalysis : public WhileAnalysisInterface<D, Dir>
+{
+  using WhileAnalysisInterface<D, Dir>::WorkList;
+  using WhileAnalysisInterface<D, Dir>::resize;
+  using WhileAnalysisInterface<D, Dir>::iterate;
 
   virtual void initialize(const WhileFunction &f)
   {
@@ -131,6 +859,7 @@ struct WhileDataFlowAnalysis : public WhileAnalysisInterface<D>
 
   void analyze(const WhileProgram &p)
   {
+    resize(p);
     for(const auto &[k, f] : p.Functions)
     {
       initialize(f);
@@ -139,16 +868,183 @@ struct WhileDataFlowAnalysis : public WhileAnalysisInterface<D>
   }
 };
 
+// Run the intra-procedural analysis a on the functions of p using up to threads
+// threads. Each thread works on its own copy of a, taking the next function not
+// yet analyzed until all functions are done. The state of each function is then
+// moved into a, in the order of the function index. Functions are analyzed
+// independently, the results are thus the same as for a.analyze(p), regardless
+// of the number of threads and the order in which functions are processed.
+template<typename A>
+void analyzeParallel(A &a, const WhileProgram &p, unsigned int threads)
+{
+  unsigned int n = p.FunctionsByIndex.size();
+  threads = std::min(threads, n);
+  if (threads <= 1)
+  {
+    a.analyze(p);
+    return;
+  }
+
+  std::vector<A> workers(threads, a);
+  std::vector<unsigned int> owner(n);
+  std::atomic<unsigned int> next(0);
+
+  auto work = [&](unsigned int t) {
+    A &w = workers[t];
+    w.resize(p);
+    for(unsigned int idx = next++; idx < n; idx = next++)
+    {
+      w.initialize(*p.FunctionsByIndex[idx]);
+      w.iterate();
+      owner[idx] = t;
+    }
+  };
+
+  std::vector<std::thread> pool;
+  for(unsigned int t = 1; t < threads; t++)
+    pool.emplace_back(work, t);
+  work(0);
+
+  for(std::thread &t : pool)
+    t.join();
+
+  a.resize(p);
+  for(unsigned int idx = 0; idx < n; idx++)
+    a.merge(workers[owner[idx]], *p.FunctionsByIndex[idx]);
+
+  for(const A &w : workers)
+    a.Stats += w.Stats;
+}
+
+// A data-flow analysis over sets represented as bit-vectors, whose transfer
+// functions are of the form out = gen | (in - kill). Analyses define the number
+// of set elements of a function and the gen/kill sets of each instruction. The
+// gen/kill sets of entire blocks are computed once per function, such that the
+// fixed-point iteration applies a single transfer function per block. Sets are
+// joined by union.
+template<WhileDirection Dir = WFORWARD>
+struct WhileGenKillAnalysis : public WhileDataFlowAnalysis<WhileBitVector, Dir>
+{
+  struct GenKill
+  {
+    WhileBitVector Gen;
+    WhileBitVector Kill;
+  };
+
+  WhileIdMap<WhileBlock, GenKill> BBGenKill;
+
+  // Gen/kill sets of a single instruction, reused across instructions.
+  GenKill InstrGenKill;
+
+  void resize(const WhileProgram &p) override
+  {
+    WhileDataFlowAnalysis<WhileBitVector, Dir>::resize(p);
+    BBGenKill.resize(p.NumBlocks);
+  }
+
+  void merge(WhileGenKillAnalysis &o, const WhileFunction &f)
+  {
+    WhileDataFlowAnalysis<WhileBitVector, Dir>::merge(o, f);
+    for(const WhileBlock &bb : f.Body)
+      BBGenKill.take(&bb, o.BBGenKill);
+  }
+
+  // Number of set elements of function f.
+  virtual unsigned int width(const WhileFunction &f) = 0;
+
+  // Add the elements generated and killed by i to gen and kill, which are
+  // empty.
+  virtual void genKill(const WhileInstr &i, WhileBitVector &gen,
+                       WhileBitVector &kill) = 0;
+
+  void initialize(const WhileFunction &f) override
+  {
+    unsigned int n = width(f);
+    WhileBitVector gen(n), kill(n);
+
+    for(const WhileBlock &bb : f.Body)
+    {
+      GenKill &bbGenKill = BBGenKill[&bb];
+      bbGenKill.Gen = WhileBitVector(n);
+      bbGenKill.Kill = WhileBitVector(n);
+
+      // compose the instructions' transfer functions in the direction of the
+      // analysis, the elements killed by an instruction are removed from the
+      // gen set of the instructions processed before it.
+      auto compose = [&](const WhileInstr &i) {
+        gen.clear();
+        kill.clear();
+        genKill(i, gen, kill);
+        bbGenKill.Gen -= kill;
+        bbGenKill.Gen |= gen;
+        bbGenKill.Kill |= kill;
+      };
+
+      if (Dir == WBACKWARD)
+        std::for_each(bb.Body.rbegin(), bb.Body.rend(), compose);
+      else
+        std::for_each(bb.Body.begin(), bb.Body.end(), compose);
+    }
+
+    WhileDataFlowAnalysis<WhileBitVector, Dir>::initialize(f);
+  }
+
+  void transferInPlace(const WhileInstr &i, WhileBitVector &value) override
+  {
+    InstrGenKill.Gen.clear();
+    InstrGenKill.Kill.clear();
+    genKill(i, InstrGenKill.Gen, InstrGenKill.Kill);
+    value.transfer(InstrGenKill.Gen, InstrGenKill.Kill);
+  }
+
+  void transferBlock(const WhileBlock *bb, WhileBitVector &value) override
+  {
+    const GenKill &bbGenKill = BBGenKill[bb];
+    value.transfer(bbGenKill.Gen, bbGenKill.Kill);
+  }
+
+  void joinInto(WhileBitVector &result, const WhileBitVector &input) override
+  {
+    result |= input;
+  }
+};
+
+// An inter-procedural analysis propagates the state at call sites to the entry
+// of the called function, and the state at returns to the successors of its
+// call sites. Functions are processed in the order of the components of the
+// call graph, callees before callers: once a call site changed, the called
+// function is processed up to its returns before the caller continues after the
+// call. Iteration across functions is thus mostly confined to recursive
+// components, whose entries are widening points, in addition to loop heads.
 template<typename D>
 struct WhileInterproceduralDataFlowAnalysis : public WhileAnalysisInterface<D>
 {
   using WhileAnalysisInterface<D>::WorkList;
+  using WhileAnalysisInterface<D>::Cache;
   using WhileAnalysisInterface<D>::BBOut;
+  using WhileAnalysisInterface<D>::readBBOut;
   using WhileAnalysisInterface<D>::join;
-  using WhileAnalysisInterface<D>::transfer;
+  using WhileAnalysisInterface<D>::joinInto;
+  using WhileAnalysisInterface<D>::transferInPlace;
   using WhileAnalysisInterface<D>::iterate;
 
-  std::map<const WhileInstr*, D> CSOut;
+  WhileIdMap<WhileInstr, D> CSOut;
+
+  // Functions that are part of a cycle of the call graph, indexed by function
+  // index.
+  std::vector<bool> Recursive;
+
+  // Output of call site cs, or D() if cs was not processed yet.
+  const D &readCSOut(const WhileInstr *cs) const
+  {
+    return CSOut.read(cs);
+  }
+
+  virtual void resize(const WhileProgram &p) override
+  {
+    WhileAnalysisInterface<D>::resize(p);
+    CSOut.resize(p.NumInstrs);
+  }
 
   virtual std::ostream &dump_entry(std::ostream &s, const D &value) = 0;
 
@@ -160,28 +1056,26 @@ struct WhileInterproceduralDataFlowAnalysis : public WhileAnalysisInterface<D>
     for (const WhileInstr *cs : f.CallSites)
     {
       s << ", ";
-      dump_entry(s, CSOut[cs]);
+      dump_entry(s, readCSOut(cs));
     }
     return s << "]\n";
   }
 
   virtual D initialize(const WhileFunction *f) = 0;
 
-  virtual D join(const WhileBlock *bb)
+  virtual D join(const WhileBlock *bb) override
   {
-    std::list<D> bbIn;
+    if (!bb->isEntry())
+      return WhileAnalysisInterface<D>::join(bb);
 
-    if (bb->isEntry())
-    {
-      bbIn.emplace_back(initialize(bb->Function));
-      for(const WhileInstr *cs : bb->Function->CallSites)
-        bbIn.emplace_back(CSOut[cs]);
-    }
+    D result(initialize(bb->Function));
+    for(const WhileInstr *cs : bb->Function->CallSites)
+      joinInto(result, readCSOut(cs));
 
     for(const auto &[pred, kind] : bb->Pred)
-      bbIn.emplace_back(BBOut[pred]);
+      joinInto(result, readBBOut(pred));
 
-    return join(bbIn);
+    return result;
   }
 
   // TODO: refactor, code is duplicated.
@@ -204,9 +1098,19 @@ struct WhileInterproceduralDataFlowAnalysis : public WhileAnalysisInterface<D>
     abort();
   }
 
+  virtual bool isWideningPoint(const WhileBlock *bb) override
+  {
+    return WorkList.isLoopHead(bb) ||
+           (bb->isEntry() && Recursive[bb->Function->Index]);
+  }
+
   virtual void initialize(const WhileProgram &p)
   {
     WorkList.clear();
+    WorkList.FunctionOrder = callGraphOrder(p, &Recursive);
+
+    if (Cache == WCACHE_INSTRS)
+      Cache = WCACHE_BLOCKS;
 
     const auto main = p.Functions.find("main");
     if (main != p.Functions.end())
@@ -218,9 +1122,9 @@ struct WhileInterproceduralDataFlowAnalysis : public WhileAnalysisInterface<D>
     }
   }
 
-  virtual D transf(const WhileInstr &i, const D input) override
+  virtual void transf(const WhileInstr &i, D &instrOut) override
   {
-    D instrOut = transfer(i, input);
+    transferInPlace(i, instrOut);
 
     if (i.Opc == WCALL)
     {
@@ -235,7 +1139,8 @@ struct WhileInterproceduralDataFlowAnalysis : public WhileAnalysisInterface<D>
           WorkList.emplace(&fun->Body.front());
 
           // prevent changing BBOut -- WRETURN will update it.
-          return BBOut[i.Block];
+          instrOut = readBBOut(i.Block);
+          return;
         }
       }
     }
@@ -254,13 +1159,12 @@ struct WhileInterproceduralDataFlowAnalysis : public WhileAnalysisInterface<D>
         }
       }
     }
-
-    return instrOut;
   }
 
 
   void analyze(const WhileProgram &p)
   {
+    resize(p);
     initialize(p);
     iterate();
   }
@@ -268,8 +1172,23 @@ struct WhileInterproceduralDataFlowAnalysis : public WhileAnalysisInterface<D>
 
 struct WhileAnalysis
 {
+  const char *Name;
   const char *Description;
-  virtual void analyze(const WhileProgram &p) = 0;
+
+  // Statistics of the last run of analyze().
+  WhileAnalysisStats Stats;
+
+  // Widening thresholds given on the command line, and whether the constants
+  // of the analyzed program are used as thresholds as well.
+  static std::set<int> WideningThresholds;
+  static bool HarvestThresholds;
+
+  // Number of threads analyzing functions in parallel.
+  static unsigned int Threads;
+
+  // Analyze p and print the results to s. Different analyses may run
+  // concurrently on the same program, which they must not modify.
+  virtual void analyze(const WhileProgram &p, std::ostream &s) = 0;
 
   WhileAnalysis(const char *name, const char *descr);
 };
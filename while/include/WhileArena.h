@@ -0,0 +1,115 @@
+// This file is part of While, an educational programming language and program
+// analysis framework.
+//
+//   Copyright 2023 Florian Brandner
+//
+// While is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// While is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+// A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// While. If not, see <https://www.gnu.org/licenses/>.
+//
+// Contact: florian.brandner@telecom-paris.fr
+//
+
+// This file defines a simple arena allocator, which hands out memory from a few
+// large chunks and releases all of it at once when the arena is destroyed.
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#pragma once
+
+class WhileArena
+{
+  // Size of the chunks from which small objects are allocated. Larger requests
+  // get a chunk of their own.
+  static const size_t ChunkSize = 64 * 1024;
+
+  std::vector<std::unique_ptr<char[]>> Chunks;
+  char *Next = nullptr;
+  char *End = nullptr;
+
+  // Objects that are not trivially destructible are destroyed along with the
+  // arena, in reverse order of their creation.
+  std::vector<std::pair<void (*)(void *), void *>> Destructors;
+
+  size_t Bytes = 0;
+
+  // Chunks are zeroed, so that the padding of objects is deterministic when
+  // they are written to a file.
+  char *newChunk(size_t size)
+  {
+    Chunks.emplace_back(new char[size]());
+    Bytes += size;
+    return Chunks.back().get();
+  }
+
+public:
+  WhileArena() = default;
+  WhileArena(const WhileArena &) = delete;
+  WhileArena &operator=(const WhileArena &) = delete;
+
+  ~WhileArena()
+  {
+    for(auto d = Destructors.rbegin(); d != Destructors.rend(); d++)
+      d->first(d->second);
+  }
+
+  void *allocate(size_t size, size_t align)
+  {
+    if (size > ChunkSize / 4)
+      return newChunk(size);
+
+    uintptr_t next = (reinterpret_cast<uintptr_t>(Next) + align - 1) & -align;
+    if (Next == nullptr || next + size > reinterpret_cast<uintptr_t>(End))
+    {
+      Next = newChunk(ChunkSize);
+      End = Next + ChunkSize;
+      next = (reinterpret_cast<uintptr_t>(Next) + align - 1) & -align;
+    }
+
+    Next = reinterpret_cast<char *>(next + size);
+    return reinterpret_cast<void *>(next);
+  }
+
+  // Allocate uninitialized memory for n objects of type T, which have to be
+  // constructed by the caller and are never destroyed.
+  template<typename T>
+  T *allocate(size_t n)
+  {
+    static_assert(std::is_trivially_destructible_v<T>,
+                  "Arrays in the arena are not destroyed.");
+    return static_cast<T *>(allocate(std::max<size_t>(n, 1) * sizeof(T),
+                                     alignof(T)));
+  }
+
+  template<typename T, typename... Args>
+  T *create(Args &&...args)
+  {
+    T *obj = new (allocate(sizeof(T), alignof(T)))
+                 T(std::forward<Args>(args)...);
+    if constexpr (!std::is_trivially_destructible_v<T>)
+      Destructors.emplace_back([](void *p) { static_cast<T *>(p)->~T(); },
+                               obj);
+    return obj;
+  }
+
+  // Number of bytes obtained from the heap.
+  size_t size() const
+  {
+    return Bytes;
+  }
+};
@@ -0,0 +1,59 @@
+// This file is part of While, an educational programming language and program
+// analysis framework.
+//
+//   Copyright 2023 Florian Brandner
+//
+// While is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// While is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+// A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// While. If not, see <https://www.gnu.org/licenses/>.
+//
+// Contact: florian.brandner@telecom-paris.fr
+//
+
+// This file defines a binary file format for compiled While programs, which
+// allows the tools to skip parsing and code generation.
+//
+// The file starts with the magic "WCFG", followed by the format version and the
+// sizes of the stored structures, as 32-bit words in host byte order. Then
+// follow the symbols of all variables, the functions, and the debug information
+// of the operands. The blocks, instructions, predecessors, and call operands of
+// each function are stored in their in-memory layout, where pointers are
+// replaced by indices into the function's arrays. When a file is loaded, it is
+// mapped into memory, or read if WHILE_MMAP_MEMORY is not set, and these arrays
+// are used in place once their pointers are relocated.
+//
+// Loading thus skips parsing and allocating the code, but it is not zero-copy:
+// the mapping is private and relocation writes to every page of code, which
+// the system then copies. Files are also large, about ten times the size of the
+// source, as instructions keep their in-memory layout. Storing indices instead
+// of pointers would allow a read-only, shared mapping, at the cost of resolving
+// an index on every access to the code by the interpreter and the analyses.
+
+#include "WhileCFG.h"
+
+#include <memory>
+#include <ostream>
+#include <string>
+
+#pragma once
+
+// Write program p in the binary format to a stream. Returns false if writing
+// failed.
+bool writeBinaryProgram(std::ostream &s, const WhileProgram &p);
+
+// Returns true if the file starts with the magic of the binary format.
+bool isBinaryProgram(const std::string &filename);
+
+// Load a program from a file in the binary format. Returns nullptr if the file
+// cannot be read, was written by another version of While, or is corrupt, and,
+// unless quiet is set, prints a message to std::cerr.
+std::unique_ptr<WhileProgram> readBinaryProgram(const std::string &filename,
+                                                bool quiet = false);
@@ -0,0 +1,194 @@
+// This file is part of While, an educational programming language and program
+// analysis framework.
+//
+//   Copyright 2023 Florian Brandner
+//
+// While is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// While is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+// A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// While. If not, see <https://www.gnu.org/licenses/>.
+//
+// Contact: florian.brandner@telecom-paris.fr
+//
+
+// This file defines a dense bit-vector representing sets of small integers,
+// e.g., register numbers or instruction indices, for set-based analysis
+// domains.
+
+#include <algorithm>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+#pragma once
+
+// A set of unsigned integers stored as a vector of 64-bit words. Set operations
+// process a whole word at a time. Words beyond the end of the vector are
+// considered to be zero, bit-vectors of different sizes can thus be combined
+// and compared, and the default constructed bit-vector is the empty set.
+struct WhileBitVector
+{
+  typedef uint64_t word_t;
+  static const unsigned int WordBits = 64;
+
+  std::vector<word_t> Words;
+
+  WhileBitVector()
+  {
+  }
+
+  // Construct an empty set with room for the elements 0 to n - 1.
+  explicit WhileBitVector(unsigned int n)
+    : Words((n + WordBits - 1) / WordBits)
+  {
+  }
+
+  unsigned int capacity() const
+  {
+    return Words.size() * WordBits;
+  }
+
+  bool test(unsigned int idx) const
+  {
+    unsigned int w = idx / WordBits;
+    return w < Words.size() && (Words[w] >> (idx % WordBits)) & 1;
+  }
+
+  void set(unsigned int idx)
+  {
+    unsigned int w = idx / WordBits;
+    if (Words.size() <= w)
+      Words.resize(w + 1);
+    Words[w] |= (word_t)1 << (idx % WordBits);
+  }
+
+  void reset(unsigned int idx)
+  {
+    unsigned int w = idx / WordBits;
+    if (w < Words.size())
+      Words[w] &= ~((word_t)1 << (idx % WordBits));
+  }
+
+  void clear()
+  {
+    std::fill(Words.begin(), Words.end(), 0);
+  }
+
+  bool empty() const
+  {
+    for(word_t w : Words)
+    {
+      if (w)
+        return false;
+    }
+    return true;
+  }
+
+  unsigned int count() const
+  {
+    unsigned int n = 0;
+    for(word_t w : Words)
+      n += __builtin_popcountll(w);
+    return n;
+  }
+
+  // Call f for each element of the set, in increasing order.
+  template<typename F>
+  void forEach(F f) const
+  {
+    for(unsigned int w = 0; w < Words.size(); w++)
+    {
+      for(word_t bits = Words[w]; bits; bits &= bits - 1)
+        f(w * WordBits + __builtin_ctzll(bits));
+    }
+  }
+
+  // Union.
+  WhileBitVector &operator|=(const WhileBitVector &o)
+  {
+    if (Words.size() < o.Words.size())
+      Words.resize(o.Words.size());
+
+    word_t *a = Words.data();
+    const word_t *b = o.Words.data();
+    for(unsigned int w = 0, n = o.Words.size(); w < n; w++)
+      a[w] |= b[w];
+    return *this;
+  }
+
+  // Intersection.
+  WhileBitVector &operator&=(const WhileBitVector &o)
+  {
+    unsigned int n = std::min(Words.size(), o.Words.size());
+    word_t *a = Words.data();
+    const word_t *b = o.Words.data();
+    for(unsigned int w = 0; w < n; w++)
+      a[w] &= b[w];
+    std::fill(Words.begin() + n, Words.end(), 0);
+    return *this;
+  }
+
+  // Difference.
+  WhileBitVector &operator-=(const WhileBitVector &o)
+  {
+    unsigned int n = std::min(Words.size(), o.Words.size());
+    word_t *a = Words.data();
+    const word_t *b = o.Words.data();
+    for(unsigned int w = 0; w < n; w++)
+      a[w] &= ~b[w];
+    return *this;
+  }
+
+  // Compute gen | (*this - kill), the transfer function of gen/kill problems,
+  // in a single pass.
+  void transfer(const WhileBitVector &gen, const WhileBitVector &kill)
+  {
+    if (Words.size() < gen.Words.size())
+      Words.resize(gen.Words.size());
+
+    word_t *a = Words.data();
+    for(unsigned int w = 0, n = Words.size(); w < n; w++)
+    {
+      word_t g = w < gen.Words.size() ? gen.Words[w] : 0;
+      word_t k = w < kill.Words.size() ? kill.Words[w] : 0;
+      a[w] = g | (a[w] & ~k);
+    }
+  }
+
+  bool operator==(const WhileBitVector &o) const
+  {
+    const std::vector<word_t> &a = Words.size() < o.Words.size() ? Words
+                                                                 : o.Words;
+    const std::vector<word_t> &b = Words.size() < o.Words.size() ? o.Words
+                                                                 : Words;
+    if (!std::equal(a.begin(), a.end(), b.begin()))
+      return false;
+
+    return std::all_of(b.begin() + a.size(), b.end(),
+                       [](word_t w) { return w == 0; });
+  }
+
+  bool operator!=(const WhileBitVector &o) const
+  {
+    return !(*this == o);
+  }
+
+  // Print the elements of the set, each preceded by prefix.
+  std::ostream &dump(std::ostream &s, const char *prefix = "") const
+  {
+    s << "{";
+    bool first = true;
+    forEach([&](unsigned int idx) {
+      s << (first ? "" : ", ") << prefix << idx;
+      first = false;
+    });
+    return s << "}";
+  }
+};
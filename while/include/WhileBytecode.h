@@ -0,0 +1,104 @@
+// This file is part of While, an educational programming language and program
+// analysis framework.
+//
+//   Copyright 2023 Florian Brandner
+//
+// While is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// While is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+// A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// While. If not, see <https://www.gnu.org/licenses/>.
+//
+// Contact: florian.brandner@telecom-paris.fr
+//
+
+// This file defines a flat, pre-decoded representation of While programs for
+// the interpreter. The instructions of each function are stored in a single
+// array of fixed-size instructions, operand kinds are resolved to a bit mask,
+// and branch targets are instruction indices within that array.
+
+#include "WhileInterpreter.h"
+
+#pragma once
+
+// Dispatch using computed gotos relies on the labels-as-values extension of
+// GCC and Clang, other compilers use the switch-based interpreter.
+#ifndef WHILE_THREADED_DISPATCH
+#if defined(__GNUC__)
+#define WHILE_THREADED_DISPATCH 1
+#else
+#define WHILE_THREADED_DISPATCH 0
+#endif
+#endif
+
+struct WhileBytecodeInstr
+{
+  // One of WhileOpcode.
+  unsigned char Opc;
+
+  // Bit i is set iff operand i is an immediate, otherwise operand i is a
+  // register of the current frame. The frame pointer is mapped to a register
+  // slot following the function's symbolic registers.
+  unsigned char Imm = 0;
+
+  // Number of arguments of a WCALL.
+  unsigned short NumArgs = 0;
+
+  // WCALL:     Callee, Dest, index of the first argument in Args
+  // WBRANCHZ:  Cond, Target
+  // WBRANCH:   Target
+  // otherwise: same operands as the corresponding WhileInstr
+  int Ops[3] = {0, 0, 0};
+
+  bool isImm(unsigned int idx) const
+  {
+    return Imm & (1 << idx);
+  }
+};
+
+struct WhileBytecodeArg
+{
+  bool IsImm;
+  int Value;
+};
+
+struct WhileBytecodeFunction
+{
+  const WhileFunction *Function;
+  std::vector<WhileBytecodeInstr> Code;
+  std::vector<WhileBytecodeArg> Args;
+
+  // Maps each instruction of Code back to the CFG, nullptr for branches that
+  // were inserted to replace fall-through edges.
+  std::vector<const WhileInstr *> Source;
+
+  // Number of register slots per frame, including the frame pointer slot.
+  unsigned int NumSlots = 0;
+  unsigned int FramePointerSlot = 0;
+
+  std::ostream &dump(std::ostream &s) const;
+};
+
+struct WhileBytecode
+{
+  std::vector<WhileBytecodeFunction> Functions;
+  int Main = -1;
+
+  explicit WhileBytecode(const WhileProgram &p);
+
+  // Execute the program using a switch over the opcodes.
+  void run(WhileState &s) const;
+
+  // Execute the program using computed gotos to handlers specialized for each
+  // combination of opcode and operand kinds. Falls back to run() if
+  // WHILE_THREADED_DISPATCH is not available.
+  void runThreaded(WhileState &s) const;
+
+  std::ostream &dump(std::ostream &s) const;
+};
@@ -22,13 +22,20 @@
 // graphs, consisting of functions, basic blocks, symbolic registers, and
 // 3-address-code-like instructions.
 
+#include "WhileArena.h"
 #include "WhileLang.h"
 
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
 #include <antlr4-runtime.h>
 
 #pragma once
 
-class WhileState;
+struct WhileState;
 
 typedef int (*WhileBuiltinFunction)(WhileState &s, std::vector<int> &ops);
 
@@ -42,6 +49,19 @@ struct WhileBuiltin
 
 extern std::map<std::string, WhileBuiltin> WhileBuiltins;
 
+// Builtins are referenced by negative indices, WhileBuiltinsByIndex maps the
+// index -1 to position 0, -2 to position 1, and so on.
+extern const std::vector<const WhileBuiltin*> WhileBuiltinsByIndex;
+
+inline const WhileBuiltin *getBuiltin(int index)
+{
+  unsigned int idx = -1 - index;
+  if (idx < WhileBuiltinsByIndex.size())
+    return WhileBuiltinsByIndex[idx];
+  else
+    return nullptr;
+}
+
 enum WhileOpKind
 {
   WFRAMEPOINTER,
@@ -58,11 +78,9 @@ struct WhileOperand
 {
   WhileOpKind Kind;
   int ValueOrIndex;
-  WhileSymbol *Symbol = nullptr;
-  std::string Comment;
 
-  WhileOperand(WhileOpKind kind = WUNKNOWN, int valoridx = 0, const std::string &comment = "")
-    : Kind(kind), ValueOrIndex(valoridx), Comment(comment)
+  WhileOperand(WhileOpKind kind = WUNKNOWN, int valoridx = 0)
+    : Kind(kind), ValueOrIndex(valoridx)
   {
   }
 
@@ -94,6 +112,95 @@ struct WhileOperand
   std::ostream &dump(std::ostream &s) const;
 };
 
+// An operand along with the debug information attached to it by the code
+// generator, i.e., the variable it refers to or a comment, such as the name of
+// a called function. Instructions only keep the operand itself, the debug
+// information is moved to WhileProgram::OperandInfo.
+struct WhileDebugOperand : public WhileOperand
+{
+  WhileSymbol *Symbol = nullptr;
+  std::string Comment;
+
+  WhileDebugOperand(WhileOpKind kind = WUNKNOWN, int valoridx = 0,
+                    const std::string &comment = "")
+    : WhileOperand(kind, valoridx), Comment(comment)
+  {
+  }
+
+  WhileDebugOperand(const WhileOperand &op, WhileSymbol *symbol)
+    : WhileOperand(op), Symbol(symbol)
+  {
+  }
+
+  bool hasDebugInfo() const
+  {
+    return Symbol || !Comment.empty();
+  }
+};
+
+// Debug information of operand Op of the instruction with Id Instr.
+struct WhileOperandInfo
+{
+  unsigned int Instr;
+  unsigned int Op;
+  WhileSymbol *Symbol;
+  std::string Comment;
+};
+
+// The operands of an instruction. Up to InlineSize operands are stored within
+// the instruction itself, longer operand lists, i.e., of calls with more than
+// one argument, are stored in WhileFunction::CallOps.
+struct WhileOperands
+{
+  static const unsigned int InlineSize = 3;
+
+  unsigned int Size = 0;
+  union
+  {
+    WhileOperand Inline[InlineSize];
+    const WhileOperand *Extra;
+  };
+
+  WhileOperands() : Extra(nullptr)
+  {
+  }
+
+  const WhileOperand *begin() const
+  {
+    return Size <= InlineSize ? Inline : Extra;
+  }
+
+  const WhileOperand *end() const
+  {
+    return begin() + Size;
+  }
+
+  unsigned int size() const
+  {
+    return Size;
+  }
+
+  bool empty() const
+  {
+    return Size == 0;
+  }
+
+  const WhileOperand &operator[](unsigned int idx) const
+  {
+    return begin()[idx];
+  }
+
+  const WhileOperand &front() const
+  {
+    return begin()[0];
+  }
+
+  const WhileOperand &back() const
+  {
+    return begin()[Size - 1];
+  }
+};
+
 enum WhileOpcode
 {
   WCALL,      // Ops: Fun Opd = Arg1, Arg2, ... ArgN
@@ -112,16 +219,81 @@ enum WhileOpcode
   WRETURN     // Ops: VallueToReturn
 };
 
+// A contiguous range of elements stored in an array of the enclosing function,
+// e.g., the instructions of a block.
+template<typename T>
+struct WhileRange
+{
+  T *First = nullptr;
+  T *Last = nullptr;
+
+  T *begin() const
+  {
+    return First;
+  }
+
+  T *end() const
+  {
+    return Last;
+  }
+
+  std::reverse_iterator<T *> rbegin() const
+  {
+    return std::reverse_iterator<T *>(Last);
+  }
+
+  std::reverse_iterator<T *> rend() const
+  {
+    return std::reverse_iterator<T *>(First);
+  }
+
+  unsigned int size() const
+  {
+    return Last - First;
+  }
+
+  bool empty() const
+  {
+    return First == Last;
+  }
+
+  T &front() const
+  {
+    return *First;
+  }
+
+  T &back() const
+  {
+    return Last[-1];
+  }
+
+  T &operator[](unsigned int idx) const
+  {
+    return First[idx];
+  }
+
+  T &at(unsigned int idx) const
+  {
+    if (idx >= size())
+      throw std::out_of_range("WhileRange::at");
+    return First[idx];
+  }
+};
+
 struct WhileBlock;
 
 struct WhileInstr
 {
   unsigned int Index;
+
+  // Dense index of the instruction within the program, see WhileProgram.
+  unsigned int Id = 0;
+
   unsigned int Line;
   unsigned int OffsetOnLine;
 
   WhileOpcode Opc;
-  std::vector<WhileOperand> Ops;
+  WhileOperands Ops;
 
   WhileBlock *Block;
 
@@ -142,12 +314,79 @@ enum WhileSuccKind
   WBRANCH_TAKEN
 };
 
+// The successors of a block, indexed by the kind of the edge, nullptr if
+// absent. Iteration visits the (kind, successor) pairs of the present
+// successors, the fall-through successor first.
+struct WhileSuccessors
+{
+  WhileBlock *Blocks[2] = {nullptr, nullptr};
+
+  struct iterator
+  {
+    const WhileSuccessors *Succ;
+    int Kind;
+
+    std::pair<WhileSuccKind, WhileBlock *> operator*() const
+    {
+      return std::make_pair((WhileSuccKind)Kind, Succ->Blocks[Kind]);
+    }
+
+    iterator &operator++()
+    {
+      do
+        Kind++;
+      while(Kind < 2 && !Succ->Blocks[Kind]);
+      return *this;
+    }
+
+    bool operator!=(const iterator &o) const
+    {
+      return Kind != o.Kind;
+    }
+  };
+
+  iterator begin() const
+  {
+    return iterator{this, Blocks[0] ? 0 : Blocks[1] ? 1 : 2};
+  }
+
+  iterator end() const
+  {
+    return iterator{this, 2};
+  }
+
+  WhileBlock *operator[](WhileSuccKind kind) const
+  {
+    return Blocks[kind];
+  }
+
+  WhileBlock *&operator[](WhileSuccKind kind)
+  {
+    return Blocks[kind];
+  }
+
+  unsigned int size() const
+  {
+    return (Blocks[0] != nullptr) + (Blocks[1] != nullptr);
+  }
+};
+
+typedef std::pair<WhileBlock *, WhileSuccKind> WhileEdge;
+
 struct WhileBlock
 {
   unsigned int Index;
-  std::list<WhileInstr> Body;
-  std::map<WhileSuccKind, WhileBlock *> Succ;
-  std::set<std::pair<WhileBlock *, WhileSuccKind> > Pred;
+
+  // Dense index of the block within the program, see WhileProgram.
+  unsigned int Id = 0;
+
+  // The block's instructions, a range of WhileFunction::Instrs.
+  WhileRange<WhileInstr> Body;
+
+  // The successors, and the predecessors along with the kind of their edge to
+  // this block, a range of WhileFunction::Preds.
+  WhileSuccessors Succ;
+  WhileRange<WhileEdge> Pred;
   WhileFunction *Function;
 
   bool isEntry() const
@@ -165,16 +404,43 @@ struct WhileBlock
   std::ostream &dump(std::ostream &s) const;
 };
 
-class WhileProgram;
+struct WhileProgram;
 
+// The code of a function is stored in arrays: the blocks of Body, in the
+// order of their index, the instructions of all blocks in Instrs, and the
+// predecessors of all blocks in Preds. Blocks refer to their instructions and
+// predecessors as ranges of these arrays. The arrays are allocated in the
+// program's arena once the code of the function is complete and are not
+// modified afterwards, pointers to their elements thus remain valid.
 struct WhileFunction
 {
   unsigned int Index;
   std::string Name;
-  std::list<WhileBlock> Body;
+  WhileRange<WhileBlock> Body;
+  WhileRange<WhileInstr> Instrs;
+  WhileRange<WhileEdge> Preds;
+
+  // Operands of the instructions with more than WhileOperands::InlineSize
+  // operands.
+  WhileRange<WhileOperand> CallOps;
+
+  // Pointers to the blocks of Body, indexed by WhileBlock::Index.
+  WhileRange<WhileBlock*> BlocksByIndex;
+
   std::map<std::string, WhileSymbol*> Locals;
   std::map<WhileSymbol*, WhileOperand> Registers;
   unsigned int FrameSize = 0;
+
+  // Number of symbolic registers used by the function's code, i.e., register
+  // operands are in the range [0, NumRegisters).
+  unsigned int NumRegisters = 0;
+
+  // Largest number of arguments passed by a call within the function.
+  unsigned int MaxCallArgs = 0;
+
+  // Number of arguments expected by the function.
+  unsigned int NumParameters = 0;
+
   std::list<WhileInstr*> CallSites;
   WhileProgram *Program;
 
@@ -183,19 +449,38 @@ struct WhileFunction
   {
   }
 
+  // Add the function's calls to the CallSites of the called functions.
+  void registerCallSites();
+
   std::ostream &dumpshort(std::ostream &s) const;
   std::ostream &dumphead(std::ostream &s) const;
   std::ostream &dump(std::ostream &s) const;
 };
 
+// A program owns the storage of its code in Arena: the blocks, instructions,
+// and operands of all functions, as well as the symbols of its variables. This
+// storage is released all at once when the program is destroyed.
 struct WhileProgram
 {
+  WhileArena Arena;
+
   std::map<std::string, WhileFunction> Functions;
   std::vector<WhileFunction*> FunctionsByIndex;
   std::map<std::string, WhileSymbol*> Globals;
   unsigned int DataSize = 0;
 
+  // Blocks and instructions are numbered consecutively from 0 over all
+  // functions, in the order of FunctionsByIndex, by generateCode. Their Ids
+  // can be used to store per-block or per-instruction data in vectors.
+  unsigned int NumBlocks = 0;
+  unsigned int NumInstrs = 0;
+
+  // Debug information of the operands of all instructions, sorted by
+  // instruction Id and operand index. Operands without a symbol or comment
+  // have no entry.
+  std::vector<WhileOperandInfo> OperandInfo;
+
   std::ostream &dump(std::ostream &s) const;
 };
 
-extern WhileProgram *generateCode(antlr4::tree::ParseTree *tree);
+extern std::unique_ptr<WhileProgram> generateCode(antlr4::tree::ParseTree *tree);
@@ -0,0 +1,84 @@
+// This file is part of While, an educational programming language and program
+// analysis framework.
+//
+//   Copyright 2023 Florian Brandner
+//
+// While is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// While is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+// A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// While. If not, see <https://www.gnu.org/licenses/>.
+//
+// Contact: florian.brandner@telecom-paris.fr
+//
+
+// This file defines an on-disk cache of compiled programs and analysis results,
+// which allows repeated runs of the tools on the same source to skip parsing
+// and analyzing.
+//
+// Entries are named by a hash of the source text and of the sources of the
+// tools, such that a changed input or a changed tool never sees stale entries.
+// The program is stored in the format of WhileBinary.h, other entries as plain
+// text. Entries are written to a temporary file first and then renamed, so
+// concurrent processes either see a complete entry or none. Once the total
+// size of the cache exceeds its limit, the least recently used entries are
+// removed.
+//
+// while-analysis uses the cache unless it is given --no-cache. The cache is
+// located in $WHILE_CACHE_DIR, or else in $XDG_CACHE_HOME/while or
+// $HOME/.cache/while. Its size is limited to $WHILE_CACHE_SIZE MiB, by default
+// DefaultSize.
+
+#include "WhileCFG.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#pragma once
+
+class WhileCache
+{
+  std::string Dir;
+  std::string Key;
+  uint64_t MaxSize;
+
+  WhileCache(const std::string &dir, const std::string &key, uint64_t maxsize)
+    : Dir(dir), Key(key), MaxSize(maxsize)
+  {
+  }
+
+  std::string path(const std::string &entry) const;
+
+  // Write an entry to a temporary file using write, then move it into place.
+  template<typename F>
+  void store(const std::string &entry, F write);
+
+  // Mark an entry as used, for the LRU order.
+  void touch(const std::string &file) const;
+
+  // Remove the least recently used entries while the cache is too large.
+  void evict() const;
+
+public:
+  static const uint64_t DefaultSize = 256;
+
+  // Open the cache for the source file. Returns nullptr if the file cannot be
+  // read or the cache directory cannot be created.
+  static std::unique_ptr<WhileCache> open(const std::string &filename);
+
+  // Load or store the compiled program.
+  std::unique_ptr<WhileProgram> loadProgram() const;
+  void storeProgram(const WhileProgram &p);
+
+  // Load or store the text of an entry, e.g., the result of an analysis.
+  // Entry names have to differ in all settings that influence the text.
+  bool load(const std::string &entry, std::string &text) const;
+  void store(const std::string &entry, const std::string &text);
+};
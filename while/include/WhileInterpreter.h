@@ -25,9 +25,22 @@
 
 #include "WhileCFG.h"
 
+#include <climits>
+
 #pragma once
 
-typedef std::list<WhileInstr>::const_iterator instruction_pointer_t;
+// Reserve the interpreter's memory using mmap, such that pages are committed
+// only when touched and guard regions are inaccessible. Other systems use a
+// plain heap allocation.
+#ifndef WHILE_MMAP_MEMORY
+#if defined(__unix__) || defined(__APPLE__)
+#define WHILE_MMAP_MEMORY 1
+#else
+#define WHILE_MMAP_MEMORY 0
+#endif
+#endif
+
+typedef const WhileInstr *instruction_pointer_t;
 
 struct WhileContext
 {
@@ -35,16 +48,64 @@ struct WhileContext
   const WhileBlock *Block;
   instruction_pointer_t InstructionPointer;
   unsigned int FramePointer;
-  std::vector<int> Registers;
+
+  // Index of the function's first register in WhileState::Registers.
+  unsigned int RegisterBase;
 
   const WhileInstr *LastCall = nullptr;
 
   WhileContext(const WhileFunction *fun, const WhileBlock *blk,
-               instruction_pointer_t ip, unsigned int fp)
-    : Function(fun), Block(blk), InstructionPointer(ip), FramePointer(fp)
+               instruction_pointer_t ip, unsigned int fp, unsigned int rb)
+    : Function(fun), Block(blk), InstructionPointer(ip), FramePointer(fp),
+      RegisterBase(rb)
+  {
+  }
+};
+
+// The memory of a While program, addresses in [0, size()) are valid. The
+// storage is surrounded by guard regions of at least GuardSize words on either
+// side, which are mapped inaccessible if WHILE_MMAP_MEMORY is set. Unchecked
+// accesses slightly out of bounds thus trap instead of corrupting the
+// interpreter's own data.
+struct WhileMemory
+{
+  static const unsigned int GuardSize = 4096;
+
+  explicit WhileMemory(unsigned int size);
+  ~WhileMemory();
+
+  WhileMemory(const WhileMemory &) = delete;
+  WhileMemory &operator=(const WhileMemory &) = delete;
+
+  unsigned int size() const
+  {
+    return Size;
+  }
+
+  bool contains(int addr) const
+  {
+    return 0 <= addr && (unsigned int)addr < Size;
+  }
+
+  // Unchecked access.
+  int &operator[](int addr)
+  {
+    return Base[addr];
+  }
+
+  int operator[](int addr) const
   {
-    Registers.reserve(200);
+    return Base[addr];
   }
+
+private:
+  // Start of the reserved region and its size in bytes.
+  void *Region;
+  std::size_t RegionSize;
+
+  // Address 0 of the program's memory within Region.
+  int *Base;
+  unsigned int Size;
 };
 
 struct WhileState
@@ -52,19 +113,76 @@ struct WhileState
   bool Done = false;
   unsigned int ExitState = -1;
   const WhileProgram *Program;
-  std::vector<int> Memory;
-  std::list<WhileContext> Context;
+  WhileMemory Memory;
+
+  // Check memory accesses against the bounds of Memory. Invalid accesses are
+  // reported and stop the execution with Error set. Without checks, accesses
+  // are performed unconditionally.
+  bool Checked = true;
+  bool Error = false;
+  std::vector<WhileContext> Context;
+
+  // Register frames of all contexts, stored contiguously in the order of the
+  // call stack. Each frame holds Function->NumRegisters values.
+  std::vector<int> Registers;
+
+  // Arguments of the current builtin call, reused across calls.
+  std::vector<int> BuiltinArgs;
+
+  // Statistics on the call stack. The frame memory is that of the contexts
+  // and registers of this interpreter, whichever engine runs the program, so
+  // that the statistics do not depend on the execution mode.
+  unsigned int MaxCallDepth = 0;
+  std::size_t MaxFrameMemory = 0;
+
+  // Default size of the stack in words. Untouched parts of the stack do not
+  // occupy physical memory.
+  static const unsigned int DefaultStackSize = 1024;
 
-  explicit WhileState(const WhileProgram *program, unsigned int stacksize = 1024);
+  // Largest size of the data and of the stack in words, addresses have to fit
+  // into an int.
+  static const unsigned int MaxStackSize = INT_MAX;
+
+  explicit WhileState(const WhileProgram *program,
+                      unsigned int stacksize = DefaultStackSize);
+
+  void pushContext(const WhileFunction *fun, unsigned int fp);
+  void popContext();
 
   int readDataOperand(const WhileInstr &i, unsigned int idx) const;
   const WhileFunction *readFunctionOperand(const WhileInstr &i) const;
   const WhileBlock *readBBOperand(const WhileInstr &i, unsigned int idx) const;
   void writeRegisterOperand(const WhileInstr &i, unsigned int idx, int value);
 
+  // Report an invalid memory access of instruction i and stop the execution.
+  void reportMemoryFault(const WhileInstr &i, int addr);
+
+  // Report that the stack cannot hold the frame of callee and stop the
+  // execution. Calls lists the active call instructions, innermost first.
+  void reportStackOverflow(const std::vector<const WhileInstr *> &calls,
+                           const WhileFunction *callee);
+
   void step(bool trace = false);
   void run(bool trace = false,
            unsigned int steps = std::numeric_limits<unsigned int>::max());
 
+  // Execute using a trace policy of WhileTrace.h or WhileProfile.h, the bool
+  // variants above use WhileTextTrace on std::cout or WhileNoTrace.
+  template<typename T>
+  void step(T &trace);
+  template<typename T>
+  void run(T &trace,
+           unsigned int steps = std::numeric_limits<unsigned int>::max());
+
+  // Update the call stack statistics for a stack of the given depth, whose
+  // functions have the given number of registers in total.
+  void updateStats(unsigned int depth, std::size_t registers)
+  {
+    MaxCallDepth = std::max(MaxCallDepth, depth);
+    MaxFrameMemory = std::max(MaxFrameMemory, depth * sizeof(WhileContext) +
+                                              registers * sizeof(int));
+  }
+
   std::ostream &dump(std::ostream &s) const;
+  std::ostream &dumpStats(std::ostream &s) const;
  };
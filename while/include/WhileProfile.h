@@ -0,0 +1,107 @@
+// This file is part of While, an educational programming language and program
+// analysis framework.
+//
+//   Copyright 2023 Florian Brandner
+//
+// While is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// While is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+// A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// While. If not, see <https://www.gnu.org/licenses/>.
+//
+// Contact: florian.brandner@telecom-paris.fr
+//
+
+// This file defines an execution profiler for the interpreter. The profiler is
+// a trace policy (see WhileTrace.h) counting the executions of every
+// instruction and block, as well as the calls and inclusive steps of every
+// function.
+
+#include "WhileTrace.h"
+
+#pragma once
+
+struct WhileFunctionProfile
+{
+  const WhileFunction *Function;
+
+  // Counters are stored densely per function, the counter of instruction i of
+  // block b is Instrs[BlockStart[b] + i.Index].
+  std::vector<unsigned int> BlockStart;
+  std::vector<const WhileInstr *> Source;
+  std::vector<uint64_t> Instrs;
+  std::vector<uint64_t> Blocks;
+
+  uint64_t Calls = 0;
+
+  // Steps executed while the function is active, including its callees. Steps
+  // of recursive activations are counted once.
+  uint64_t Inclusive = 0;
+
+  // Number of active calls and the step count when the outermost one started.
+  unsigned int Active = 0;
+  uint64_t EnterStep = 0;
+
+  explicit WhileFunctionProfile(const WhileFunction &f);
+
+  // Steps executed by the function's own instructions.
+  uint64_t self() const;
+};
+
+struct WhileProfile
+{
+  uint64_t Steps = 0;
+  std::vector<WhileFunctionProfile> Functions;
+
+  explicit WhileProfile(const WhileProgram &p);
+
+  void begin(const WhileContext &ctx, const WhileInstr &i)
+  {
+    WhileFunctionProfile &f = Functions[ctx.Function->Index];
+    unsigned int bb = ctx.Block->Index;
+
+    Steps++;
+    f.Instrs[f.BlockStart[bb] + i.Index]++;
+    if (i.Index == 0)
+      f.Blocks[bb]++;
+  }
+
+  void event(WhileTraceEvent e, int value = 0)
+  {
+  }
+
+  void enter(const WhileFunction &f)
+  {
+    WhileFunctionProfile &fp = Functions[f.Index];
+    fp.Calls++;
+    if (fp.Active++ == 0)
+      fp.EnterStep = Steps;
+  }
+
+  void leave(const WhileFunction &f)
+  {
+    WhileFunctionProfile &fp = Functions[f.Index];
+    if (--fp.Active == 0)
+      fp.Inclusive += Steps - fp.EnterStep;
+  }
+
+  void end()
+  {
+  }
+
+  // Account for functions still active when the program terminated.
+  void finish();
+
+  // Print a report of the hottest functions, source lines, and blocks.
+  std::ostream &dump(std::ostream &s, unsigned int top = 20) const;
+
+  // Print all counters in a machine-readable format.
+  std::ostream &dumpJSON(std::ostream &s) const;
+  std::ostream &dumpCSV(std::ostream &s) const;
+};
@@ -0,0 +1,166 @@
+// This file is part of While, an educational programming language and program
+// analysis framework.
+//
+//   Copyright 2023 Florian Brandner
+//
+// While is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// While is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+// A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// While. If not, see <https://www.gnu.org/licenses/>.
+//
+// Contact: florian.brandner@telecom-paris.fr
+//
+
+// This file defines the trace policies of the interpreter. WhileState::step is
+// specialized for each policy, the untraced policy consists of empty inline
+// functions only and thus adds no overhead to normal execution.
+//
+// A policy provides:
+//   begin(ctx, i)    before instruction i is executed in context ctx,
+//   event(e, value)  when i writes a value, takes a branch, or returns,
+//   enter(f)         after a call to function f pushed a new context,
+//   leave(f)         before returning from function f,
+//   end()            after i was executed.
+
+#include "WhileInterpreter.h"
+
+#include <cstdint>
+#include <fstream>
+
+#pragma once
+
+// Observable effect of an instruction, in addition to its execution.
+enum WhileTraceEvent
+{
+  WTRACE_NONE,
+  WTRACE_WRITES,
+  WTRACE_TAKEN,
+  WTRACE_RETURNS
+};
+
+struct WhileNoTrace
+{
+  void begin(const WhileContext &ctx, const WhileInstr &i)
+  {
+  }
+
+  void event(WhileTraceEvent e, int value = 0)
+  {
+  }
+
+  void enter(const WhileFunction &f)
+  {
+  }
+
+  void leave(const WhileFunction &f)
+  {
+  }
+
+  void end()
+  {
+  }
+};
+
+// Print each step to a stream in a human-readable form.
+struct WhileTextTrace
+{
+  std::ostream &Out;
+
+  explicit WhileTextTrace(std::ostream &out) : Out(out)
+  {
+  }
+
+  void begin(const WhileContext &ctx, const WhileInstr &i);
+  void event(WhileTraceEvent e, int value = 0);
+  void end();
+
+  void enter(const WhileFunction &f)
+  {
+  }
+
+  void leave(const WhileFunction &f)
+  {
+  }
+};
+
+// One step of a binary trace. The instruction's index within its block and the
+// trace event share a word, the event is stored in the two upper bits.
+struct WhileTraceRecord
+{
+  uint32_t Function;
+  uint32_t Block;
+  uint32_t InstrAndEvent;
+  uint32_t FramePointer;
+  int32_t Value;
+
+  unsigned int instr() const
+  {
+    return InstrAndEvent & 0x3fffffff;
+  }
+
+  WhileTraceEvent event() const
+  {
+    return (WhileTraceEvent)(InstrAndEvent >> 30);
+  }
+};
+
+// Write each step as a WhileTraceRecord to a file. Records are buffered and
+// written in bulk. The file starts with the magic "WTRC", followed by the
+// format version and the record size, as 32-bit words in host byte order.
+struct WhileBinaryTrace
+{
+  static const uint32_t Version = 1;
+  static const unsigned int BufferSize = 1 << 16;
+
+  std::ofstream Out;
+  std::vector<WhileTraceRecord> Buffer;
+
+  explicit WhileBinaryTrace(const std::string &filename);
+  ~WhileBinaryTrace();
+
+  bool good() const
+  {
+    return Out.good();
+  }
+
+  void begin(const WhileContext &ctx, const WhileInstr &i)
+  {
+    Buffer.push_back({ctx.Function->Index, ctx.Block->Index, i.Index,
+                      ctx.FramePointer, 0});
+  }
+
+  void event(WhileTraceEvent e, int value = 0)
+  {
+    WhileTraceRecord &r = Buffer.back();
+    r.InstrAndEvent |= (uint32_t)e << 30;
+    r.Value = value;
+  }
+
+  void enter(const WhileFunction &f)
+  {
+  }
+
+  void leave(const WhileFunction &f)
+  {
+  }
+
+  void end()
+  {
+    if (Buffer.size() == BufferSize)
+      flush();
+  }
+
+  void flush();
+};
+
+// Print a binary trace of program p in the format of WhileTextTrace. Returns
+// false if the file is not a valid trace of p.
+bool dumpBinaryTrace(std::ostream &s, const std::string &filename,
+                     const WhileProgram &p);
@@ -329,7 +329,7 @@ call_args returns[std::vector<ExprContext*> args]
   |
   ;
 
-expr returns[WhileType Ty = WERR; WhileOperand Op;]
+expr returns[WhileType Ty = WERR; WhileDebugOperand Op;]
   : N                          {$Ty = WINT;}                                                      #ExN
   | ID                         {$Ty = typeOfVariable($ID);}                                       #ExID
   | ID op='[' expr ']'         {$Ty = typeOfArray(typeOfVariable($ID), $expr.Ty, $op);}           #ExArray
@@ -25,13 +25,20 @@
 #include "WhileAnalysis.h"
 #include "WhileLang.h"
 #include "WhileCFG.h"
+#include "WhileBinary.h"
+#include "WhileCache.h"
 #include "WhileColor.h"
 
+#include <atomic>
 #include <iostream>
 #include <string>
+#include <cstdlib>
 #include <cstring>
 #include <list>
+#include <memory>
 #include <numeric>
+#include <sstream>
+#include <thread>
 
 #include "antlr4-runtime.h"
 #include "WhileParser.h"
@@ -43,8 +50,12 @@ const char *WhileTypes[4] = {"int", "int *", "int[]", "unknown"};
 
 std::map<std::string, WhileAnalysis*> WhileAnalyses;
 
+std::set<int> WhileAnalysis::WideningThresholds;
+bool WhileAnalysis::HarvestThresholds = true;
+unsigned int WhileAnalysis::Threads = 1;
+
 WhileAnalysis::WhileAnalysis(const char *name, const char *descr)
-  : Description(descr)
+  : Name(name), Description(descr)
 {
   WhileAnalyses.emplace(name, this);
 }
@@ -60,10 +71,28 @@ static void version()
 
 static void usage(const char *prog)
 {
-  std::cerr << "Usage: " << prog << "[-d] <input.whl>\n\n"
+  std::cerr << "Usage: " << prog
+            << "[-d] [-s] [-j <n>] [-t <n>] [-w <n>] [-W] [--no-cache] "
+            << "<input.whl>\n\n"
             << "\t-d\tDump control-flow graph.\n"
+            << "\t-s\tPrint the number of block visits of each analysis to\n"
+            << "\t\tstderr.\n"
+            << "\t-j <n>\tRun up to n analyses in parallel.\n"
+            << "\t-t <n>\tAnalyze the functions of the program on n threads.\n"
+            << "\t-w <n>\tAdd n to the widening thresholds.\n"
+            << "\t-W\tDo not use the program's constants as widening\n"
+            << "\t\tthresholds.\n"
+            << "\t--no-cache\n\t\tDo not use the cache of compiled programs and\n"
+            << "\t\tanalysis results, see below.\n"
             << "\t-l\tPrint list of available analyses.\n"
-            << "\t-v\tPrint version and license information.\n\n";
+            << "\t-v\tPrint version and license information.\n\n"
+            << "The input is either While source code or a program compiled\n"
+            << "by while-compile.\n\n"
+            << "By default, compiled programs and analysis results are kept\n"
+            << "in a cache and reused for unchanged sources. The cache is\n"
+            << "located in $WHILE_CACHE_DIR, or else in $XDG_CACHE_HOME/while\n"
+            << "or $HOME/.cache/while, and holds up to $WHILE_CACHE_SIZE MiB\n"
+            << "(default " << WhileCache::DefaultSize << "), see WhileCache.h.\n\n";
 
   version();
   exit(3);
@@ -75,13 +104,28 @@ int main(int argc, char *argv[])
     usage(argv[0]);
 
   bool dump = false;
+  bool stats = false;
+  bool usecache = true;
   std::string filename = argv[argc-1];
-  std::set<WhileAnalysis*> ToRun;
+  unsigned int jobs = 1;
+  std::map<std::string, WhileAnalysis*> ToRun;
 
   for(int i = 1; i < argc-1; i++)
   {
     if (!std::strcmp(argv[i], "-d"))
       dump = true;
+    else if (!std::strcmp(argv[i], "-s"))
+      stats = true;
+    else if (!std::strcmp(argv[i], "-j") && i + 1 < argc - 1)
+      jobs = std::max(1, std::atoi(argv[++i]));
+    else if (!std::strcmp(argv[i], "-t") && i + 1 < argc - 1)
+      WhileAnalysis::Threads = std::max(1, std::atoi(argv[++i]));
+    else if (!std::strcmp(argv[i], "-w") && i + 1 < argc - 1)
+      WhileAnalysis::WideningThresholds.emplace(std::atoi(argv[++i]));
+    else if (!std::strcmp(argv[i], "-W"))
+      WhileAnalysis::HarvestThresholds = false;
+    else if (!std::strcmp(argv[i], "--no-cache"))
+      usecache = false;
     else if (!std::strcmp(argv[i], "-l"))
     {
       std::cout << "List of available analyses:\n";
@@ -103,30 +147,122 @@ int main(int argc, char *argv[])
         return 1;
       }
       else
-        ToRun.emplace(a->second);
+        ToRun.emplace(*a);
     }
   }
 
-  antlr4::ANTLRFileStream input(filename);
-  WhileLexer lexer(&input);
-  antlr4::CommonTokenStream tokens(&lexer);
-  WhileParser parser(&tokens);
+  // Programs compiled by while-compile are loaded directly, skipping the
+  // parser and the code generator, as are sources found in the cache.
+  std::unique_ptr<WhileCache> cache;
+  std::unique_ptr<const WhileProgram> program;
+  if (isBinaryProgram(filename))
+  {
+    program = readBinaryProgram(filename);
+    if (!program)
+      return 1;
+  }
+  else if (usecache)
+  {
+    cache = WhileCache::open(filename);
+    if (cache)
+      program = cache->loadProgram();
+  }
 
-  antlr4::tree::ParseTree *tree = parser.program();
+  if (!program)
+  {
+    antlr4::ANTLRFileStream input(filename);
+    WhileLexer lexer(&input);
+    antlr4::CommonTokenStream tokens(&lexer);
+    WhileParser parser(&tokens);
 
-  if (parser.getNumberOfSyntaxErrors() != 0)
-    return 1;
+    antlr4::tree::ParseTree *tree = parser.program();
 
-  if (parser.Error)
-    return 2;
+    if (parser.getNumberOfSyntaxErrors() != 0)
+      return 1;
 
-  WhileProgram *program = generateCode(tree);
+    if (parser.Error)
+      return 2;
+
+    std::unique_ptr<WhileProgram> p = generateCode(tree);
+    if (cache)
+      cache->storeProgram(*p);
+    program = std::move(p);
+  }
 
   if (dump)
     program->dump(std::cout);
 
-  for(WhileAnalysis *a : ToRun)
-    a->analyze(*program);
+  // Run the analyses on up to jobs threads, each taking the next analysis not
+  // yet started. Every analysis prints into its own buffer, the buffers are
+  // emitted in the order of the analyses' names once all analyses are done.
+  // Results in the cache are reused, including the statistics, which are kept
+  // in the first line of an entry.
+  std::ostringstream settings;
+  settings << WhileAnalysis::HarvestThresholds;
+  for(int t : WhileAnalysis::WideningThresholds)
+    settings << " " << t;
+  std::vector<WhileAnalysis*> analyses;
+  for(const auto &[name, a] : ToRun)
+    analyses.emplace_back(a);
+
+  std::vector<std::ostringstream> outputs(analyses.size());
+  std::atomic<unsigned int> next(0);
+  auto work = [&]() {
+    for(unsigned int idx = next++; idx < analyses.size(); idx = next++)
+    {
+      WhileAnalysis *a = analyses[idx];
+      WhileAnalysisStats &s = a->Stats;
+      std::string entry = std::string(a->Name) + " " + settings.str();
+      std::string text;
+      if (cache && cache->load(entry, text))
+      {
+        std::string::size_type eol = text.find('\n');
+        std::istringstream in(text.substr(0, eol));
+        if (eol != std::string::npos &&
+            in >> s.BlockVisits >> s.NarrowingVisits >> s.MaxBlockVisits)
+        {
+          outputs[idx] << text.substr(eol + 1);
+          continue;
+        }
+      }
+
+      std::ostringstream out;
+      a->analyze(*program, out);
+      text = out.str();
+      outputs[idx] << text;
+
+      if (cache)
+      {
+        std::ostringstream entrytext;
+        entrytext << s.BlockVisits << " " << s.NarrowingVisits << " "
+                  << s.MaxBlockVisits << "\n" << text;
+        cache->store(entry, entrytext.str());
+      }
+    }
+  };
+
+  std::vector<std::thread> pool;
+  jobs = std::min<unsigned int>(jobs, analyses.size());
+  for(unsigned int t = 1; t < jobs; t++)
+    pool.emplace_back(work);
+  work();
+
+  for(std::thread &t : pool)
+    t.join();
+
+  for(unsigned int idx = 0; idx < analyses.size(); idx++)
+  {
+    const WhileAnalysis *a = analyses[idx];
+    std::cout << outputs[idx].str();
+
+    if (stats)
+    {
+      const WhileAnalysisStats &s = a->Stats;
+      std::cerr << a->Name << ": " << s.BlockVisits << " block visits ("
+                << s.NarrowingVisits << " narrowing), at most "
+                << s.MaxBlockVisits << " per block\n";
+    }
+  }
 
   return 0;
 }
@@ -0,0 +1,750 @@
+// This file is part of While, an educational programming language and program
+// analysis framework.
+//
+//   Copyright 2023 Florian Brandner
+//
+// While is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// While is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+// A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// While. If not, see <https://www.gnu.org/licenses/>.
+//
+// Contact: florian.brandner@telecom-paris.fr
+//
+
+// Writing and loading of While programs in the binary format, see
+// WhileBinary.h.
+
+#include "WhileBinary.h"
+#include "WhileInterpreter.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+
+#if WHILE_MMAP_MEMORY
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static const char WhileBinaryMagic[4] = {'W', 'C', 'F', 'G'};
+
+static const uint32_t WhileBinaryVersion = 2;
+
+// The sizes of the structures stored in their in-memory layout. A file can only
+// be loaded by a build of While with the same layout.
+static const uint32_t WhileBinaryLayout[] = {
+  sizeof(WhileBlock), sizeof(WhileInstr), sizeof(WhileEdge),
+  sizeof(WhileOperand), sizeof(void*)};
+
+// Symbol index of operands without symbol.
+static const uint32_t WhileNoSymbol = UINT32_MAX;
+
+// Replace a pointer into an array starting at first by its index.
+template<typename T>
+static T *toIndex(const T *ptr, const T *first)
+{
+  return reinterpret_cast<T*>(ptr - first);
+}
+
+// Replace an index, stored in ptr, by a pointer into range. The index one past
+// the end of the range is only valid if end is set.
+template<typename T>
+static bool relocate(T *&ptr, WhileRange<T> range, bool end = false)
+{
+  uintptr_t idx = reinterpret_cast<uintptr_t>(ptr);
+  if (idx > range.size() || (idx == range.size() && !end))
+    return false;
+
+  ptr = range.First + idx;
+  return true;
+}
+
+// Enumerations in a file may hold any value, they are checked as integers.
+template<typename E>
+static uint32_t rawValue(const E &e)
+{
+  static_assert(sizeof(E) == sizeof(uint32_t));
+  uint32_t v;
+  std::memcpy(&v, &e, sizeof(v));
+  return v;
+}
+
+struct WhileBinaryWriter
+{
+  std::ostream &Out;
+  uint64_t Pos = 0;
+
+  void bytes(const void *data, size_t size)
+  {
+    Out.write(static_cast<const char*>(data), size);
+    Pos += size;
+  }
+
+  void word(uint32_t w)
+  {
+    bytes(&w, sizeof(w));
+  }
+
+  void string(const std::string &str)
+  {
+    word(str.size());
+    bytes(str.data(), str.size());
+  }
+
+  // Pad to a multiple of 8 bytes, the largest alignment of the structures
+  // stored in their in-memory layout.
+  void align()
+  {
+    static const char zero[8] = {};
+    bytes(zero, (8 - Pos % 8) % 8);
+  }
+
+  // Write a copy of n objects, after replacing their pointers using relocate.
+  template<typename T, typename F>
+  void array(const T *objs, size_t n, F relocate)
+  {
+    align();
+    std::vector<char> buffer(n * sizeof(T));
+    if (n)
+      std::memcpy(buffer.data(), objs, buffer.size());
+
+    T *copy = reinterpret_cast<T*>(buffer.data());
+    for(size_t idx = 0; idx < n; idx++)
+      relocate(copy[idx]);
+
+    bytes(buffer.data(), buffer.size());
+  }
+};
+
+struct WhileBinaryReader
+{
+  char *Data;
+  size_t Size;
+  size_t Pos = 0;
+  bool Error = false;
+
+  WhileBinaryReader(char *data, size_t size) : Data(data), Size(size)
+  {
+  }
+
+  char *bytes(size_t size)
+  {
+    if (Error || size > Size - Pos)
+    {
+      Error = true;
+      return nullptr;
+    }
+
+    char *result = Data + Pos;
+    Pos += size;
+    return result;
+  }
+
+  uint32_t word()
+  {
+    uint32_t w = 0;
+    if (const char *p = bytes(sizeof(w)))
+      std::memcpy(&w, p, sizeof(w));
+    return w;
+  }
+
+  std::string string()
+  {
+    uint32_t n = word();
+    const char *p = bytes(n);
+    return p ? std::string(p, n) : std::string();
+  }
+
+  void align()
+  {
+    bytes((8 - Pos % 8) % 8);
+  }
+
+  // The next n objects in place, the data is aligned to 8 bytes.
+  template<typename T>
+  WhileRange<T> array(uint32_t n)
+  {
+    align();
+    WhileRange<T> result;
+    if (char *p = bytes((size_t)n * sizeof(T)))
+    {
+      result.First = reinterpret_cast<T*>(p);
+      result.Last = result.First + n;
+    }
+    return result;
+  }
+};
+
+#if WHILE_MMAP_MEMORY
+// A file mapped into memory, which is unmapped along with the arena of the
+// program loaded from it.
+struct WhileMappedFile
+{
+  void *Data;
+  size_t Size;
+
+  WhileMappedFile(void *data, size_t size) : Data(data), Size(size)
+  {
+  }
+
+  ~WhileMappedFile()
+  {
+    munmap(Data, Size);
+  }
+};
+
+// Map the file into memory owned by the arena. The mapping is private,
+// relocating the pointers of the code does not modify the file.
+static char *loadFile(const std::string &filename, WhileArena &arena,
+                      size_t &size)
+{
+  int fd = open(filename.c_str(), O_RDONLY);
+  struct stat st;
+  if (fd < 0 || fstat(fd, &st) != 0 || st.st_size <= 0)
+  {
+    if (fd >= 0)
+      close(fd);
+    return nullptr;
+  }
+
+  void *data = mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+                    fd, 0);
+  close(fd);
+  if (data == MAP_FAILED)
+    return nullptr;
+
+  size = st.st_size;
+  arena.create<WhileMappedFile>(data, size);
+  return static_cast<char*>(data);
+}
+#else
+// Read the file into memory owned by the arena.
+static char *loadFile(const std::string &filename, WhileArena &arena,
+                      size_t &size)
+{
+  std::ifstream in(filename, std::ios::binary | std::ios::ate);
+  std::streamoff end = in ? (std::streamoff)in.tellg() : -1;
+  if (end <= 0 || !in.seekg(0))
+    return nullptr;
+
+  size = end;
+  uint64_t *data = arena.allocate<uint64_t>((size + 7) / 8);
+  char *bytes = reinterpret_cast<char*>(data);
+  return in.read(bytes, size) ? bytes : nullptr;
+}
+#endif
+
+bool writeBinaryProgram(std::ostream &s, const WhileProgram &p)
+{
+  // Number the symbols referenced by the program.
+  std::map<const WhileSymbol*, uint32_t> ids;
+  std::vector<const WhileSymbol*> symbols;
+  auto add = [&](const WhileSymbol *sym) {
+    if (sym && ids.emplace(sym, symbols.size()).second)
+      symbols.emplace_back(sym);
+  };
+
+  for(const auto &[name, sym] : p.Globals)
+    add(sym);
+  for(const WhileFunction *f : p.FunctionsByIndex)
+  {
+    for(const auto &[name, sym] : f->Locals)
+      add(sym);
+    for(const auto &[sym, op] : f->Registers)
+      add(sym);
+  }
+  for(const WhileOperandInfo &info : p.OperandInfo)
+    add(info.Symbol);
+
+  WhileBinaryWriter out{s};
+  out.bytes(WhileBinaryMagic, sizeof(WhileBinaryMagic));
+  out.word(WhileBinaryVersion);
+  for(uint32_t size : WhileBinaryLayout)
+    out.word(size);
+
+  out.word(symbols.size());
+  out.word(p.FunctionsByIndex.size());
+  out.word(p.DataSize);
+  out.word(p.NumBlocks);
+  out.word(p.NumInstrs);
+
+  for(const WhileSymbol *sym : symbols)
+  {
+    out.string(sym->Name);
+    out.word(sym->Type);
+    out.word(sym->Size);
+    out.word(sym->Offset);
+    out.word(sym->AddressTaken);
+    out.word(sym->Init.size());
+    for(int value : sym->Init)
+      out.word(value);
+  }
+
+  out.word(p.Globals.size());
+  for(const auto &[name, sym] : p.Globals)
+    out.word(ids[sym]);
+
+  for(const WhileFunction *f : p.FunctionsByIndex)
+  {
+    out.string(f->Name);
+    out.word(f->FrameSize);
+    out.word(f->NumRegisters);
+    out.word(f->MaxCallArgs);
+    out.word(f->NumParameters);
+    out.word(f->Body.size());
+    out.word(f->Instrs.size());
+    out.word(f->Preds.size());
+    out.word(f->CallOps.size());
+
+    out.word(f->Locals.size());
+    for(const auto &[name, sym] : f->Locals)
+      out.word(ids[sym]);
+
+    out.word(f->Registers.size());
+    for(const auto &[sym, op] : f->Registers)
+    {
+      out.word(ids[sym]);
+      out.word(op.Kind);
+      out.word(op.ValueOrIndex);
+    }
+
+    out.array(f->Body.First, f->Body.size(), [f](WhileBlock &b) {
+      b.Body.First = toIndex(b.Body.First, f->Instrs.First);
+      b.Body.Last = toIndex(b.Body.Last, f->Instrs.First);
+      b.Pred.First = toIndex(b.Pred.First, f->Preds.First);
+      b.Pred.Last = toIndex(b.Pred.Last, f->Preds.First);
+      // Successors are stored as index + 1, to distinguish them from missing
+      // successors.
+      for(WhileBlock *&succ : b.Succ.Blocks)
+      {
+        if (succ)
+          succ = reinterpret_cast<WhileBlock*>((uintptr_t)succ->Index + 1);
+      }
+      b.Function = nullptr;
+    });
+
+    out.array(f->Instrs.First, f->Instrs.size(), [f](WhileInstr &i) {
+      i.Block = reinterpret_cast<WhileBlock*>((uintptr_t)i.Block->Index);
+      if (i.Ops.size() > WhileOperands::InlineSize)
+        i.Ops.Extra = toIndex(i.Ops.Extra, f->CallOps.First);
+    });
+
+    out.array(f->Preds.First, f->Preds.size(), [](WhileEdge &e) {
+      e.first = reinterpret_cast<WhileBlock*>((uintptr_t)e.first->Index);
+    });
+
+    out.array(f->CallOps.First, f->CallOps.size(), [](WhileOperand &op) {
+    });
+  }
+
+  out.word(p.OperandInfo.size());
+  for(const WhileOperandInfo &info : p.OperandInfo)
+  {
+    out.word(info.Instr);
+    out.word(info.Op);
+    out.word(info.Symbol ? ids[info.Symbol] : WhileNoSymbol);
+    out.string(info.Comment);
+  }
+
+  return s.good();
+}
+
+bool isBinaryProgram(const std::string &filename)
+{
+  std::ifstream in(filename, std::ios::binary);
+
+  char magic[sizeof(WhileBinaryMagic)];
+  in.read(magic, sizeof(magic));
+  return in && std::equal(magic, magic + sizeof(magic), WhileBinaryMagic);
+}
+
+// The number of operands of each opcode, calls have at least two operands.
+static const unsigned int WhileNumOperands[] = {2, 3, 3, 3, 3, 3, 3, 3, 3, 3,
+                                                3, 2, 1, 1};
+
+// The role of an operand determines the kinds it may have: a destination is a
+// register, a data value is a register, an immediate, or the frame pointer.
+enum WhileOperandRole
+{
+  WROLE_DEST,
+  WROLE_DATA,
+  WROLE_BLOCK,
+  WROLE_FUNCTION
+};
+
+// The roles of the operands of each opcode, the arguments of calls following
+// the destination are data values.
+static const WhileOperandRole WhileOperandRoles[][3] = {
+  {WROLE_FUNCTION, WROLE_DEST, WROLE_DATA}, // WCALL
+  {WROLE_DEST, WROLE_DATA, WROLE_DATA},     // WLOAD
+  {WROLE_DATA, WROLE_DATA, WROLE_DATA},     // WSTORE
+  {WROLE_DEST, WROLE_DATA, WROLE_DATA},     // WPLUS
+  {WROLE_DEST, WROLE_DATA, WROLE_DATA},     // WMINUS
+  {WROLE_DEST, WROLE_DATA, WROLE_DATA},     // WMULT
+  {WROLE_DEST, WROLE_DATA, WROLE_DATA},     // WDIV
+  {WROLE_DEST, WROLE_DATA, WROLE_DATA},     // WEQUAL
+  {WROLE_DEST, WROLE_DATA, WROLE_DATA},     // WUNEQUAL
+  {WROLE_DEST, WROLE_DATA, WROLE_DATA},     // WLESS
+  {WROLE_DEST, WROLE_DATA, WROLE_DATA},     // WLESSEQUAL
+  {WROLE_DATA, WROLE_BLOCK},                // WBRANCHZ
+  {WROLE_BLOCK},                            // WBRANCH
+  {WROLE_DATA}                              // WRETURN
+};
+
+static bool isValidOperand(const WhileOperand &op, WhileOperandRole role,
+                           const WhileFunction &f, unsigned int numFunctions)
+{
+  int v = op.ValueOrIndex;
+  if (rawValue(op.Kind) > WUNKNOWN)
+    return false;
+
+  switch(role)
+  {
+    case WROLE_DEST:
+      return op.Kind == WREGISTER && 0 <= v && (unsigned int)v < f.NumRegisters;
+    case WROLE_DATA:
+      if (op.Kind == WREGISTER)
+        return 0 <= v && (unsigned int)v < f.NumRegisters;
+      return op.Kind == WIMMEDIATE || op.Kind == WFRAMEPOINTER;
+    case WROLE_BLOCK:
+      return op.Kind == WBLOCK && 0 <= v && (unsigned int)v < f.Body.size();
+    case WROLE_FUNCTION:
+      if (op.Kind != WFUNCTION)
+        return false;
+      return v < 0 ? getBuiltin(v) != nullptr : (unsigned int)v < numFunctions;
+  }
+  return false;
+}
+
+static bool hasValidOperands(const WhileInstr &i, const WhileFunction &f,
+                             unsigned int numFunctions)
+{
+  unsigned int n = WhileNumOperands[i.Opc];
+  if (i.Opc == WCALL ? i.Ops.size() < n : i.Ops.size() != n)
+    return false;
+
+  for(unsigned int idx = 0; idx < i.Ops.size(); idx++)
+  {
+    WhileOperandRole role = WhileOperandRoles[i.Opc][std::min(idx, 2u)];
+    if (!isValidOperand(i.Ops[idx], role, f, numFunctions))
+      return false;
+  }
+
+  return true;
+}
+
+// Calls have to pass as many arguments as the called function or builtin
+// expects. All functions have to be read before.
+static bool hasValidArguments(const WhileInstr &i, const WhileProgram &p)
+{
+  if (i.Opc != WCALL)
+    return true;
+
+  int callee = i.Ops[0].ValueOrIndex;
+  unsigned int numArgs = i.Ops.size() - 2;
+  if (callee < 0)
+    return numArgs == getBuiltin(callee)->ParameterTypes.size();
+  return numArgs == p.FunctionsByIndex[callee]->NumParameters;
+}
+
+// Only the last instruction of a block may branch, and its target has to be
+// the taken successor. Blocks that do not end in a branch or return have to
+// fall through to the next block.
+static bool hasValidSuccessors(const WhileBlock &b)
+{
+  for(const WhileInstr &i : b.Body)
+  {
+    if ((i.Opc == WBRANCH || i.Opc == WBRANCHZ) && &i != &b.Body.back())
+      return false;
+  }
+
+  const WhileInstr *last = b.Body.empty() ? nullptr : &b.Body.back();
+  if (last && (last->Opc == WBRANCH || last->Opc == WBRANCHZ))
+  {
+    const WhileOperand &target = last->Ops[last->Opc == WBRANCH ? 0 : 1];
+    if (b.Succ[WBRANCH_TAKEN] !=
+        b.Function->BlocksByIndex[target.ValueOrIndex])
+      return false;
+  }
+  else if (b.Succ[WBRANCH_TAKEN])
+    return false;
+
+  return (last && (last->Opc == WBRANCH || last->Opc == WRETURN)) ||
+         b.Succ[WFALL_THROUGH];
+}
+
+// Read the function with index idx, relocating its code in place. Its blocks
+// and instructions have to be numbered from nextBlock and nextInstr on, which
+// are advanced past them.
+static bool readFunction(WhileBinaryReader &in, WhileProgram &p,
+                         unsigned int idx, unsigned int numFunctions,
+                         const std::vector<WhileSymbol*> &symbols,
+                         unsigned int &nextBlock, unsigned int &nextInstr)
+{
+  std::string name = in.string();
+  auto [it, inserted] = p.Functions.try_emplace(name, name, idx, &p);
+  if (!inserted)
+    return false;
+
+  WhileFunction &f = it->second;
+  p.FunctionsByIndex.emplace_back(&f);
+
+  f.FrameSize = in.word();
+  f.NumRegisters = in.word();
+  f.MaxCallArgs = in.word();
+  f.NumParameters = in.word();
+  uint32_t numBlocks = in.word();
+  uint32_t numInstrs = in.word();
+  uint32_t numEdges = in.word();
+  uint32_t numCallOps = in.word();
+
+  for(uint32_t n = in.word(); n && !in.Error; n--)
+  {
+    uint32_t sym = in.word();
+    if (sym >= symbols.size())
+      return false;
+    f.Locals.emplace(symbols[sym]->Name, symbols[sym]);
+  }
+
+  for(uint32_t n = in.word(); n && !in.Error; n--)
+  {
+    uint32_t sym = in.word();
+    uint32_t kind = in.word();
+    WhileOperand op(WREGISTER, in.word());
+    if (sym >= symbols.size() || kind != WREGISTER)
+      return false;
+    f.Registers.emplace(symbols[sym], op);
+  }
+
+  f.Body = in.array<WhileBlock>(numBlocks);
+  f.Instrs = in.array<WhileInstr>(numInstrs);
+  f.Preds = in.array<WhileEdge>(numEdges);
+  f.CallOps = in.array<WhileOperand>(numCallOps);
+  if (in.Error || numBlocks == 0)
+    return false;
+
+  // Frames have to fit into the largest stack, every register is either a
+  // variable's or defined by an instruction.
+  if (f.FrameSize > WhileState::MaxStackSize ||
+      f.NumRegisters > f.Registers.size() + numInstrs)
+    return false;
+
+  f.BlocksByIndex.First = f.BlocksByIndex.Last =
+    p.Arena.allocate<WhileBlock*>(numBlocks);
+
+  // The instructions and predecessors of the blocks have to cover the arrays
+  // in the order of the blocks.
+  WhileInstr *instrs = f.Instrs.First;
+  WhileEdge *preds = f.Preds.First;
+  unsigned int numSuccs = 0;
+  unsigned int maxCallArgs = 0;
+  for(WhileBlock &b : f.Body)
+  {
+    if (b.Index != f.BlocksByIndex.size() || b.Id != nextBlock++)
+      return false;
+
+    if (!relocate(b.Body.First, f.Instrs, true) ||
+        !relocate(b.Body.Last, f.Instrs, true) ||
+        !relocate(b.Pred.First, f.Preds, true) ||
+        !relocate(b.Pred.Last, f.Preds, true) ||
+        b.Body.First != instrs || b.Body.Last < b.Body.First ||
+        b.Pred.First != preds || b.Pred.Last < b.Pred.First)
+      return false;
+
+    instrs = b.Body.Last;
+    preds = b.Pred.Last;
+
+    for(WhileBlock *&succ : b.Succ.Blocks)
+    {
+      if (succ)
+      {
+        succ = reinterpret_cast<WhileBlock*>((uintptr_t)succ - 1);
+        if (!relocate(succ, f.Body))
+          return false;
+        numSuccs++;
+      }
+    }
+
+    // The fall-through successor is the next block.
+    if (b.Succ[WFALL_THROUGH] && b.Succ[WFALL_THROUGH] != &b + 1)
+      return false;
+
+    b.Function = &f;
+    *f.BlocksByIndex.Last++ = &b;
+  }
+
+  if (instrs != f.Instrs.Last || preds != f.Preds.Last ||
+      numSuccs != f.Preds.size())
+    return false;
+
+  for(WhileBlock &b : f.Body)
+  {
+    for(unsigned int idx = 0; idx < b.Body.size(); idx++)
+    {
+      WhileInstr &i = b.Body[idx];
+      if (!relocate(i.Block, f.Body) || i.Block != &b || i.Index != idx ||
+          i.Id != nextInstr++ || rawValue(i.Opc) > WRETURN)
+        return false;
+
+      if (i.Ops.Size > WhileOperands::InlineSize)
+      {
+        uintptr_t first = reinterpret_cast<uintptr_t>(i.Ops.Extra);
+        if (first > f.CallOps.size() || i.Ops.Size > f.CallOps.size() - first)
+          return false;
+        i.Ops.Extra = f.CallOps.First + first;
+      }
+
+      if (!hasValidOperands(i, f, numFunctions))
+        return false;
+
+      if (i.Opc == WCALL)
+        maxCallArgs = std::max<unsigned int>(maxCallArgs, i.Ops.size() - 2);
+    }
+
+    if (!hasValidSuccessors(b))
+      return false;
+
+    for(WhileEdge &e : b.Pred)
+    {
+      if (!relocate(e.first, f.Body) ||
+          rawValue(e.second) > WBRANCH_TAKEN ||
+          e.first->Succ[e.second] != &b)
+        return false;
+    }
+  }
+
+  return f.MaxCallArgs == maxCallArgs;
+}
+
+static bool readProgram(WhileBinaryReader &in, WhileProgram &p)
+{
+  uint32_t numSymbols = in.word();
+  uint32_t numFunctions = in.word();
+  p.DataSize = in.word();
+  p.NumBlocks = in.word();
+  p.NumInstrs = in.word();
+  if (p.DataSize > WhileState::MaxStackSize)
+    return false;
+
+  std::vector<WhileSymbol*> symbols;
+  for(uint32_t n = numSymbols; n && !in.Error; n--)
+  {
+    std::string name = in.string();
+    uint32_t type = in.word();
+    uint32_t size = in.word();
+    uint32_t offset = in.word();
+    if (type > WERR)
+      return false;
+
+    WhileSymbol *sym = p.Arena.create<WhileSymbol>(name, (WhileType)type,
+                                                   size, offset);
+    sym->AddressTaken = in.word();
+
+    for(uint32_t k = in.word(); k && !in.Error; k--)
+      sym->Init.emplace_back(in.word());
+    symbols.emplace_back(sym);
+  }
+
+  for(uint32_t n = in.word(); n && !in.Error; n--)
+  {
+    uint32_t sym = in.word();
+    if (sym >= symbols.size() ||
+        symbols[sym]->Init.size() > p.DataSize ||
+        symbols[sym]->Offset > p.DataSize - symbols[sym]->Init.size())
+      return false;
+    p.Globals.emplace(symbols[sym]->Name, symbols[sym]);
+  }
+
+  // Blocks and instructions are numbered consecutively, see generateCode.
+  unsigned int nextBlock = 0, nextInstr = 0;
+  for(uint32_t idx = 0; idx < numFunctions && !in.Error; idx++)
+  {
+    if (!readFunction(in, p, idx, numFunctions, symbols, nextBlock,
+                      nextInstr))
+      return false;
+  }
+
+  if (in.Error || nextBlock != p.NumBlocks || nextInstr != p.NumInstrs)
+    return false;
+
+  for(WhileFunction *f : p.FunctionsByIndex)
+  {
+    for(const WhileInstr &i : f->Instrs)
+    {
+      if (!hasValidArguments(i, p))
+        return false;
+    }
+  }
+
+  for(WhileFunction *f : p.FunctionsByIndex)
+    f->registerCallSites();
+
+  for(uint32_t n = in.word(); n && !in.Error; n--)
+  {
+    uint32_t instr = in.word();
+    uint32_t op = in.word();
+    uint32_t sym = in.word();
+    std::string comment = in.string();
+    if (instr >= p.NumInstrs ||
+        (sym != WhileNoSymbol && sym >= symbols.size()))
+      return false;
+
+    p.OperandInfo.push_back({instr, op,
+                             sym != WhileNoSymbol ? symbols[sym] : nullptr,
+                             comment});
+  }
+
+  return !in.Error && in.Pos == in.Size;
+}
+
+std::unique_ptr<WhileProgram> readBinaryProgram(const std::string &filename,
+                                                bool quiet)
+{
+  std::unique_ptr<WhileProgram> p = std::make_unique<WhileProgram>();
+  size_t size = 0;
+  char *data = loadFile(filename, p->Arena, size);
+  if (!data)
+  {
+    if (!quiet)
+      std::cerr << "Cannot read '" << filename << "'.\n";
+    return nullptr;
+  }
+
+  WhileBinaryReader in(data, size);
+  const char *magic = in.bytes(sizeof(WhileBinaryMagic));
+  bool valid = magic && std::equal(magic, magic + sizeof(WhileBinaryMagic),
+                                   WhileBinaryMagic);
+  valid = valid && in.word() == WhileBinaryVersion;
+  for(uint32_t size : WhileBinaryLayout)
+    valid = valid && in.word() == size;
+
+  if (!valid)
+  {
+    if (!quiet)
+      std::cerr << "'" << filename << "' was not compiled by this version of "
+                 "While.\n";
+    return nullptr;
+  }
+
+  if (!readProgram(in, *p))
+  {
+    if (!quiet)
+      std::cerr << "'" << filename << "' is not a valid compiled While "
+                 "program.\n";
+    return nullptr;
+  }
+
+  return p;
+}
@@ -0,0 +1,42 @@
+# This file is part of While, an educational programming language and program
+# analysis framework.
+#
+#   Copyright 2023 Florian Brandner
+#
+# While is free software: you can redistribute it and/or modify it under the
+# terms of the GNU General Public License as published by the Free Software
+# Foundation, either version 3 of the License, or (at your option) any later
+# version.
+#
+# While is distributed in the hope that it will be useful, but WITHOUT ANY
+# WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+# A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License along with
+# While. If not, see <https://www.gnu.org/licenses/>.
+#
+# Contact: florian.brandner@telecom-paris.fr
+#
+
+
+# This script computes an identifier of the sources of the tools, which the
+# cache of while-analysis uses to tell builds apart, see WhileCache.cc. It is
+# run by the build with -DOUTPUT=<header> -DSOURCES=<files>, and rewrites the
+# header only if the identifier changed.
+
+list(SORT SOURCES)
+set(ids "")
+foreach(source ${SOURCES})
+  get_filename_component(name ${source} NAME)
+  file(SHA256 ${source} id)
+  string(APPEND ids "${name} ${id}\n")
+endforeach()
+string(SHA256 id "${ids}")
+
+file(WRITE ${OUTPUT}.tmp
+  "// Generated by WhileBuildId.cmake, do not edit.\n\n"
+  "#pragma once\n\n"
+  "#define WHILE_BUILD_ID \"${id}\"\n")
+execute_process(COMMAND ${CMAKE_COMMAND} -E copy_if_different ${OUTPUT}.tmp
+                                                                ${OUTPUT})
+file(REMOVE ${OUTPUT}.tmp)
@@ -0,0 +1,700 @@
+// This file is part of While, an educational programming language and program
+// analysis framework.
+//
+//   Copyright 2023 Florian Brandner
+//
+// While is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// While is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+// A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// While. If not, see <https://www.gnu.org/licenses/>.
+//
+// Contact: florian.brandner@telecom-paris.fr
+//
+
+// This file implements the translation of control-flow graphs to flat bytecode
+// and an interpreter executing the bytecode. Blocks are laid out in the order
+// of the function's body, fall-through edges to blocks that do not follow in
+// this order are replaced by explicit branches.
+
+#include "WhileBytecode.h"
+
+#include <cassert>
+
+// implemented in WhileCFG.cc
+extern const char *WhileOpcodes[];
+
+static bool endsWithJump(const WhileBlock &bb)
+{
+  if (bb.Body.empty())
+    return false;
+
+  WhileOpcode opc = bb.Body.back().Opc;
+  return opc == WBRANCH || opc == WRETURN;
+}
+
+static bool needsFallThroughBranch(const WhileBlock &bb, const WhileBlock *next)
+{
+  const WhileBlock *ft = bb.Succ[WFALL_THROUGH];
+  return !endsWithJump(bb) && ft && ft != next;
+}
+
+static void decodeDataOperand(const WhileBytecodeFunction &bf,
+                              WhileBytecodeInstr &bi, unsigned int idx,
+                              const WhileOperand &op)
+{
+  switch (op.Kind)
+  {
+    case WREGISTER:
+      bi.Ops[idx] = op.ValueOrIndex;
+      return;
+    case WFRAMEPOINTER:
+      bi.Ops[idx] = bf.FramePointerSlot;
+      return;
+    case WIMMEDIATE:
+      bi.Imm |= 1 << idx;
+      bi.Ops[idx] = op.ValueOrIndex;
+      return;
+
+    case WBLOCK:
+    case WFUNCTION:
+    case WUNKNOWN:
+      assert("Operand is not a data value.");
+  }
+  abort();
+}
+
+static WhileBytecodeArg decodeArg(const WhileBytecodeFunction &bf,
+                                  const WhileOperand &op)
+{
+  WhileBytecodeInstr tmp;
+  decodeDataOperand(bf, tmp, 0, op);
+  return WhileBytecodeArg{tmp.isImm(0), tmp.Ops[0]};
+}
+
+static void decodeFunction(WhileBytecodeFunction &bf, const WhileFunction &f)
+{
+  bf.Function = &f;
+  bf.FramePointerSlot = f.NumRegisters;
+  bf.NumSlots = bf.FramePointerSlot + 1;
+
+  // compute the index of the first instruction of every block.
+  std::vector<int> start;
+  unsigned int size = 0;
+  for(auto bb = f.Body.begin(), e = f.Body.end(); bb != e; bb++)
+  {
+    auto next = std::next(bb);
+    start.emplace_back(size);
+    size += bb->Body.size();
+    if (needsFallThroughBranch(*bb, next == e ? nullptr : &*next))
+      size++;
+  }
+
+  bf.Code.reserve(size);
+  bf.Source.reserve(size);
+
+  for(auto bb = f.Body.begin(), e = f.Body.end(); bb != e; bb++)
+  {
+    for(const WhileInstr &i : bb->Body)
+    {
+      const auto &ops = i.Ops;
+      WhileBytecodeInstr bi;
+      bi.Opc = i.Opc;
+
+      switch(i.Opc)
+      {
+        case WCALL:
+        {
+          // Ops: Fun Opd = Arg1, Arg2, ... ArgN
+          assert(ops.size() > 2);
+          bi.Ops[0] = ops[0].ValueOrIndex;
+          if (bi.Ops[0] < 0 && !getBuiltin(bi.Ops[0]))
+          {
+            assert("Unexpected builtin.");
+            abort();
+          }
+          bi.Ops[1] = ops[1].ValueOrIndex;
+          bi.Ops[2] = bf.Args.size();
+          bi.NumArgs = ops.size() - 2;
+          for(unsigned int idx = 2; idx < ops.size(); idx++)
+            bf.Args.emplace_back(decodeArg(bf, ops[idx]));
+          break;
+        }
+        case WBRANCHZ:
+          decodeDataOperand(bf, bi, 0, ops[0]);
+          bi.Ops[1] = start.at(ops[1].ValueOrIndex);
+          break;
+        case WBRANCH:
+          bi.Ops[0] = start.at(ops[0].ValueOrIndex);
+          break;
+        case WRETURN:
+          decodeDataOperand(bf, bi, 0, ops[0]);
+          break;
+        case WLOAD:
+        case WSTORE:
+        case WPLUS:
+        case WMINUS:
+        case WMULT:
+        case WDIV:
+        case WEQUAL:
+        case WUNEQUAL:
+        case WLESS:
+        case WLESSEQUAL:
+          assert(ops.size() == 3);
+          for(unsigned int idx = 0; idx < ops.size(); idx++)
+            decodeDataOperand(bf, bi, idx, ops[idx]);
+          break;
+      }
+
+      bf.Code.emplace_back(bi);
+      bf.Source.emplace_back(&i);
+    }
+
+    auto next = std::next(bb);
+    if (needsFallThroughBranch(*bb, next == e ? nullptr : &*next))
+    {
+      WhileBytecodeInstr bi;
+      bi.Opc = WBRANCH;
+      bi.Ops[0] = start.at(bb->Succ[WFALL_THROUGH]->Index);
+      bf.Code.emplace_back(bi);
+      bf.Source.emplace_back(nullptr);
+    }
+  }
+
+  assert(bf.Code.size() == size);
+}
+
+WhileBytecode::WhileBytecode(const WhileProgram &p)
+{
+  Functions.resize(p.FunctionsByIndex.size());
+  for(const WhileFunction *f : p.FunctionsByIndex)
+    decodeFunction(Functions.at(f->Index), *f);
+
+  const auto main = p.Functions.find("main");
+  if (main != p.Functions.end())
+    Main = main->second.Index;
+}
+
+namespace
+{
+  struct WhileBytecodeFrame
+  {
+    const WhileBytecodeFunction *Function;
+    unsigned int Registers;
+    unsigned int ReturnAddress = 0;
+    int ReturnRegister;
+  };
+
+  // Call stack and register file shared by the dispatch loops. The loops keep
+  // copies of Code and Regs in locals and reload them after calls and
+  // returns, which may move the register file.
+  struct WhileBytecodeMachine
+  {
+    const WhileBytecode &Bytecode;
+    WhileState &State;
+
+    std::vector<WhileBytecodeFrame> Frames;
+    std::vector<int> Registers;
+    std::vector<int> Args;
+
+    // Number of registers of the active functions without the slots added by
+    // the translation, counted as the interpreter does for the statistics.
+    std::size_t NumRegisters;
+
+    const WhileBytecodeFunction *Function;
+    const WhileBytecodeInstr *Code;
+    int *Regs;
+
+    WhileBytecodeMachine(const WhileBytecode &bc, WhileState &s)
+      : Bytecode(bc), State(s), Function(&bc.Functions.at(bc.Main))
+    {
+      Frames.push_back({Function, 0, 0, -1});
+      NumRegisters = Function->Function->NumRegisters;
+      Registers.resize(Function->NumSlots);
+      updateStats();
+
+      unsigned int maxArgs = 0;
+      for(const WhileBytecodeFunction &bf : bc.Functions)
+        maxArgs = std::max(maxArgs, bf.Function->MaxCallArgs);
+      Args.reserve(maxArgs);
+
+      Regs = Registers.data();
+      Regs[Function->FramePointerSlot] = s.Program->DataSize;
+      Code = Function->Code.data();
+    }
+
+    void updateStats()
+    {
+      State.updateStats(Frames.size(), NumRegisters);
+    }
+
+    static int readArg(const WhileBytecodeArg &a, const int *regs)
+    {
+      return a.IsImm ? a.Value : regs[a.Value];
+    }
+
+    // Report an invalid memory access of instruction i of the current
+    // function.
+    void fault(const WhileBytecodeInstr &i, int addr)
+    {
+      State.reportMemoryFault(*Function->Source[&i - Code], addr);
+    }
+
+    // Report that the frame of callee, called by instruction i of the current
+    // function, does not fit on the stack.
+    void overflow(const WhileBytecodeInstr &i,
+                  const WhileBytecodeFunction *callee)
+    {
+      std::vector<const WhileInstr *> calls;
+      calls.emplace_back(Function->Source[&i - Code]);
+      for(auto f = Frames.rbegin() + 1; f != Frames.rend(); f++)
+        calls.emplace_back(f->Function->Source[f->ReturnAddress - 1]);
+
+      State.reportStackOverflow(calls, callee->Function);
+    }
+
+    // Enter the function called by i, returns the callee's first instruction
+    // or nullptr if the stack overflows or the arguments could not be passed.
+    const WhileBytecodeInstr *call(const WhileBytecodeInstr &i,
+                                   const WhileBytecodeInstr *ip)
+    {
+      const WhileBytecodeArg *argv = Function->Args.data() + i.Ops[2];
+      const WhileBytecodeFunction *callee = &Bytecode.Functions[i.Ops[0]];
+      unsigned int nextFP = Regs[Function->FramePointerSlot] +
+                            Function->Function->FrameSize;
+
+      if (nextFP > State.Memory.size() ||
+          callee->Function->FrameSize > State.Memory.size() - nextFP)
+      {
+        overflow(i, callee);
+        return nullptr;
+      }
+
+      if (State.Checked && i.NumArgs &&
+          !State.Memory.contains(nextFP + i.NumArgs - 1))
+      {
+        fault(i, nextFP + i.NumArgs - 1);
+        return nullptr;
+      }
+
+      for(unsigned int a = 0; a < i.NumArgs; a++)
+        State.Memory[nextFP + a] = readArg(argv[a], Regs);
+
+      unsigned int base = Frames.back().Registers + Function->NumSlots;
+      Frames.back().ReturnAddress = ip - Code;
+      Frames.push_back({callee, base, 0, i.Ops[1]});
+
+      Registers.resize(base + callee->NumSlots);
+      Regs = Registers.data() + base;
+      std::fill(Regs, Regs + callee->NumSlots, 0);
+      Regs[callee->FramePointerSlot] = nextFP;
+      NumRegisters += callee->Function->NumRegisters;
+      updateStats();
+
+      Function = callee;
+      Code = Function->Code.data();
+      return Code;
+    }
+
+    // Call the builtin referenced by i, returns false if the program exited.
+    bool builtin(const WhileBytecodeInstr &i)
+    {
+      const WhileBytecodeArg *argv = Function->Args.data() + i.Ops[2];
+
+      Args.clear();
+      for(unsigned int a = 0; a < i.NumArgs; a++)
+        Args.emplace_back(readArg(argv[a], Regs));
+
+      const WhileBuiltin *b = WhileBuiltinsByIndex[-1 - i.Ops[0]];
+      Regs[i.Ops[1]] = b->Function(State, Args);
+      return !State.Done;
+    }
+
+    // Leave the current function, returns the instruction following the call
+    // or nullptr when main returned.
+    const WhileBytecodeInstr *ret(int retval)
+    {
+      int dest = Frames.back().ReturnRegister;
+      NumRegisters -= Function->Function->NumRegisters;
+      Frames.pop_back();
+
+      if (Frames.empty())
+      {
+        State.Done = true;
+        State.ExitState = retval;
+        return nullptr;
+      }
+
+      const WhileBytecodeFrame &caller = Frames.back();
+      Function = caller.Function;
+      Registers.resize(caller.Registers + Function->NumSlots);
+      Regs = Registers.data() + caller.Registers;
+      Regs[dest] = retval;
+
+      Code = Function->Code.data();
+      return Code + caller.ReturnAddress;
+    }
+  };
+}
+
+static inline int readOperand(const WhileBytecodeInstr &i, unsigned int idx,
+                              const int *regs)
+{
+  return i.isImm(idx) ? i.Ops[idx] : regs[i.Ops[idx]];
+}
+
+template<bool Checked>
+static void runSwitch(const WhileBytecode &bc, WhileState &s)
+{
+  if (bc.Main < 0)
+  {
+    s.Done = true;
+    return;
+  }
+
+  WhileBytecodeMachine m(bc, s);
+  const WhileBytecodeInstr *code = m.Code;
+  const WhileBytecodeInstr *ip = code;
+  int *regs = m.Regs;
+
+  while(true)
+  {
+    const WhileBytecodeInstr &i = *ip++;
+    switch(i.Opc)
+    {
+      case WCALL:
+        if (i.Ops[0] >= 0)
+        {
+          ip = m.call(i, ip);
+          if (!ip)
+            return;
+          code = m.Code;
+          regs = m.Regs;
+        }
+        else if (!m.builtin(i))
+          return;
+        break;
+      case WLOAD:
+      {
+        // Ops: OpD = [BaseAddress + Offset]
+        int addr = readOperand(i, 1, regs) + readOperand(i, 2, regs);
+        if (Checked && !s.Memory.contains(addr))
+        {
+          m.fault(i, addr);
+          return;
+        }
+        regs[i.Ops[0]] = s.Memory[addr];
+        break;
+      }
+      case WSTORE:
+      {
+        // Ops: [BaseAddress + Offset] = ValueToStore
+        int addr = readOperand(i, 0, regs) + readOperand(i, 1, regs);
+        if (Checked && !s.Memory.contains(addr))
+        {
+          m.fault(i, addr);
+          return;
+        }
+        s.Memory[addr] = readOperand(i, 2, regs);
+        break;
+      }
+      case WPLUS:
+        regs[i.Ops[0]] = readOperand(i, 1, regs) + readOperand(i, 2, regs);
+        break;
+      case WMINUS:
+        regs[i.Ops[0]] = readOperand(i, 1, regs) - readOperand(i, 2, regs);
+        break;
+      case WMULT:
+        regs[i.Ops[0]] = readOperand(i, 1, regs) * readOperand(i, 2, regs);
+        break;
+      case WDIV:
+        regs[i.Ops[0]] = readOperand(i, 1, regs) / readOperand(i, 2, regs);
+        break;
+      case WEQUAL:
+        regs[i.Ops[0]] = readOperand(i, 1, regs) == readOperand(i, 2, regs);
+        break;
+      case WUNEQUAL:
+        regs[i.Ops[0]] = readOperand(i, 1, regs) != readOperand(i, 2, regs);
+        break;
+      case WLESS:
+        regs[i.Ops[0]] = readOperand(i, 1, regs) < readOperand(i, 2, regs);
+        break;
+      case WLESSEQUAL:
+        regs[i.Ops[0]] = readOperand(i, 1, regs) <= readOperand(i, 2, regs);
+        break;
+      case WBRANCHZ:
+        if (readOperand(i, 0, regs) == 0)
+          ip = code + i.Ops[1];
+        break;
+      case WBRANCH:
+        ip = code + i.Ops[0];
+        break;
+      case WRETURN:
+        ip = m.ret(readOperand(i, 0, regs));
+        if (!ip)
+          return;
+        code = m.Code;
+        regs = m.Regs;
+        break;
+      default:
+        assert("Unexpected opcode.");
+        abort();
+    }
+  }
+}
+
+void WhileBytecode::run(WhileState &s) const
+{
+  if (s.Checked)
+    runSwitch<true>(*this, s);
+  else
+    runSwitch<false>(*this, s);
+}
+
+#if WHILE_THREADED_DISPATCH
+
+// Handlers are specialized for every combination of opcode and immediate mask,
+// the handler table is indexed by Opc and Imm. Operand 0 of arithmetic
+// instructions and loads is always a register, thus only masks with bit 0
+// cleared are reachable for them.
+
+#define R(n) regs[i->Ops[n]]
+#define I(n) i->Ops[n]
+
+#define DISPATCH()                                                            \
+  do                                                                          \
+  {                                                                           \
+    i = ip++;                                                                 \
+    goto *Handlers[i->Opc][i->Imm];                                           \
+  } while (0)
+
+#define BINARY(NAME, OP)                                                      \
+  NAME##_RR: R(0) = R(1) OP R(2); DISPATCH();                                 \
+  NAME##_IR: R(0) = I(1) OP R(2); DISPATCH();                                 \
+  NAME##_RI: R(0) = R(1) OP I(2); DISPATCH();                                 \
+  NAME##_II: R(0) = I(1) OP I(2); DISPATCH();
+
+#define BINARY_HANDLERS(NAME)                                                 \
+  {&&NAME##_RR, &&INVALID, &&NAME##_IR, &&INVALID,                            \
+   &&NAME##_RI, &&INVALID, &&NAME##_II, &&INVALID}
+
+#define READ(ADDR)                                                            \
+  addr = ADDR;                                                                \
+  if (Checked && !memory.contains(addr))                                      \
+    goto FAULT;                                                               \
+  R(0) = memory[addr];                                                        \
+  DISPATCH();
+
+#define WRITE(ADDR, VALUE)                                                    \
+  addr = ADDR;                                                                \
+  if (Checked && !memory.contains(addr))                                      \
+    goto FAULT;                                                               \
+  memory[addr] = VALUE;                                                       \
+  DISPATCH();
+
+template<bool Checked>
+static void runThreadedDispatch(const WhileBytecode &bc, WhileState &s)
+{
+  if (bc.Main < 0)
+  {
+    s.Done = true;
+    return;
+  }
+
+  static const void *const Handlers[][8] =
+  {
+    /* WCALL      */ {&&CALL, &&INVALID, &&INVALID, &&INVALID,
+                      &&INVALID, &&INVALID, &&INVALID, &&INVALID},
+    /* WLOAD      */ BINARY_HANDLERS(LOAD),
+    /* WSTORE     */ {&&STORE_RRR, &&STORE_IRR, &&STORE_RIR, &&STORE_IIR,
+                      &&STORE_RRI, &&STORE_IRI, &&STORE_RII, &&STORE_III},
+    /* WPLUS      */ BINARY_HANDLERS(PLUS),
+    /* WMINUS     */ BINARY_HANDLERS(MINUS),
+    /* WMULT      */ BINARY_HANDLERS(MULT),
+    /* WDIV       */ BINARY_HANDLERS(DIV),
+    /* WEQUAL     */ BINARY_HANDLERS(EQUAL),
+    /* WUNEQUAL   */ BINARY_HANDLERS(UNEQUAL),
+    /* WLESS      */ BINARY_HANDLERS(LESS),
+    /* WLESSEQUAL */ BINARY_HANDLERS(LESSEQUAL),
+    /* WBRANCHZ   */ {&&BRANCHZ_R, &&BRANCHZ_I, &&INVALID, &&INVALID,
+                      &&INVALID, &&INVALID, &&INVALID, &&INVALID},
+    /* WBRANCH    */ {&&BRANCH, &&INVALID, &&INVALID, &&INVALID,
+                      &&INVALID, &&INVALID, &&INVALID, &&INVALID},
+    /* WRETURN    */ {&&RETURN_R, &&RETURN_I, &&INVALID, &&INVALID,
+                      &&INVALID, &&INVALID, &&INVALID, &&INVALID},
+  };
+  static_assert(sizeof(Handlers) / sizeof(Handlers[0]) == WRETURN + 1,
+                "Handler table does not cover all opcodes.");
+
+  WhileBytecodeMachine m(bc, s);
+  const WhileBytecodeInstr *code = m.Code;
+  const WhileBytecodeInstr *ip = code;
+  const WhileBytecodeInstr *i;
+  int *regs = m.Regs;
+  WhileMemory &memory = s.Memory;
+  int addr;
+
+  DISPATCH();
+
+CALL:
+  if (I(0) >= 0)
+  {
+    ip = m.call(*i, ip);
+    if (!ip)
+      return;
+    code = m.Code;
+    regs = m.Regs;
+  }
+  else if (!m.builtin(*i))
+    return;
+  DISPATCH();
+
+LOAD_RR: READ(R(1) + R(2))
+LOAD_IR: READ(I(1) + R(2))
+LOAD_RI: READ(R(1) + I(2))
+LOAD_II: READ(I(1) + I(2))
+
+STORE_RRR: WRITE(R(0) + R(1), R(2))
+STORE_IRR: WRITE(I(0) + R(1), R(2))
+STORE_RIR: WRITE(R(0) + I(1), R(2))
+STORE_IIR: WRITE(I(0) + I(1), R(2))
+STORE_RRI: WRITE(R(0) + R(1), I(2))
+STORE_IRI: WRITE(I(0) + R(1), I(2))
+STORE_RII: WRITE(R(0) + I(1), I(2))
+STORE_III: WRITE(I(0) + I(1), I(2))
+
+BINARY(PLUS, +)
+BINARY(MINUS, -)
+BINARY(MULT, *)
+BINARY(DIV, /)
+BINARY(EQUAL, ==)
+BINARY(UNEQUAL, !=)
+BINARY(LESS, <)
+BINARY(LESSEQUAL, <=)
+
+BRANCHZ_R:
+  if (R(0) == 0)
+    ip = code + I(1);
+  DISPATCH();
+BRANCHZ_I:
+  if (I(0) == 0)
+    ip = code + I(1);
+  DISPATCH();
+
+BRANCH:
+  ip = code + I(0);
+  DISPATCH();
+
+RETURN_R:
+  ip = m.ret(R(0));
+  goto RETURN;
+RETURN_I:
+  ip = m.ret(I(0));
+RETURN:
+  if (!ip)
+    return;
+  code = m.Code;
+  regs = m.Regs;
+  DISPATCH();
+
+FAULT:
+  m.fault(*i, addr);
+  return;
+
+INVALID:
+  assert("Unexpected opcode.");
+  abort();
+}
+
+void WhileBytecode::runThreaded(WhileState &s) const
+{
+  if (s.Checked)
+    runThreadedDispatch<true>(*this, s);
+  else
+    runThreadedDispatch<false>(*this, s);
+}
+
+#undef WRITE
+#undef READ
+#undef BINARY_HANDLERS
+#undef BINARY
+#undef DISPATCH
+#undef I
+#undef R
+
+#else
+
+void WhileBytecode::runThreaded(WhileState &s) const
+{
+  run(s);
+}
+
+#endif
+
+std::ostream &WhileBytecodeFunction::dump(std::ostream &s) const
+{
+  s << "fun " << Function->Index << ": " << Function->Name << ": "
+    << NumSlots << " slots\n";
+
+  auto operand = [this](std::ostream &s, bool imm, int value) -> std::ostream&
+  {
+    if (imm)
+      return s << value;
+    else if ((unsigned int)value == FramePointerSlot)
+      return s << "FP";
+    else
+      return s << "R" << value;
+  };
+
+  for(unsigned int pc = 0; pc < Code.size(); pc++)
+  {
+    const WhileBytecodeInstr &i = Code[pc];
+    s << std::setw(4) << pc << ": " << std::setw(10) << WhileOpcodes[i.Opc]
+      << "  ";
+
+    switch(i.Opc)
+    {
+      case WCALL:
+        s << "F" << i.Ops[0] << ", R" << i.Ops[1];
+        for(unsigned int a = 0; a < i.NumArgs; a++)
+        {
+          const WhileBytecodeArg &arg = Args[i.Ops[2] + a];
+          operand(s << ", ", arg.IsImm, arg.Value);
+        }
+        break;
+      case WBRANCHZ:
+        operand(s, i.isImm(0), i.Ops[0]) << ", @" << i.Ops[1];
+        break;
+      case WBRANCH:
+        s << "@" << i.Ops[0];
+        break;
+      case WRETURN:
+        operand(s, i.isImm(0), i.Ops[0]);
+        break;
+      default:
+        operand(s, i.isImm(0), i.Ops[0]) << ", ";
+        operand(s, i.isImm(1), i.Ops[1]) << ", ";
+        operand(s, i.isImm(2), i.Ops[2]);
+    }
+
+    if (Source[pc])
+      s << "\t # " << Source[pc]->Line << ":" << Source[pc]->OffsetOnLine;
+    s << "\n";
+  }
+
+  return s;
+}
+
+std::ostream &WhileBytecode::dump(std::ostream &s) const
+{
+  for(const WhileBytecodeFunction &f : Functions)
+    f.dump(s);
+
+  return s;
+}
@@ -26,7 +26,10 @@
 
 #include "WhileBaseListener.h"
 
+#include <algorithm>
 #include <cassert>
+#include <deque>
+#include <numeric>
 
 // implemented in WhileInterpreter.cc
 extern int WhilePrintInt(WhileState &s, std::vector<int> &ops);
@@ -43,23 +46,54 @@ std::map<std::string, WhileBuiltin> WhileBuiltins =
   {"exit"       , {-5, {WINT}, &WhileExit}}
 };
 
+static std::vector<const WhileBuiltin*> indexBuiltins()
+{
+  std::vector<const WhileBuiltin*> result(WhileBuiltins.size());
+  for(const auto &[n, b] : WhileBuiltins)
+  {
+    assert(b.Index < 0 && -1 - b.Index < (int)result.size());
+    result[-1 - b.Index] = &b;
+  }
+
+  return result;
+}
+
+const std::vector<const WhileBuiltin*> WhileBuiltinsByIndex = indexBuiltins();
+
 const char *WhileOpcodes[] = {"WCALL", "WLOAD", "WSTORE", "WPLUS", "WMINUS",
                               "WMULT", "WDIR", "WEQUAL", "WUNEQUAL", "WLESS",
                               "WLESSEQUAL", "WBRANCHZ", "WBRANCH", "WRETURN"};
 
 const char *WhileSuccKinds[] = {"FT", "BT"};
 
+// An instruction of the current function while its code is generated, whose
+// operands still carry their debug information, see layoutFunction.
+struct WhileCodeGenInstr
+{
+  unsigned int Line;
+  unsigned int OffsetOnLine;
+  WhileOpcode Opc;
+  std::vector<WhileDebugOperand> Ops;
+};
+
 class  WhileCodeGenListener : public WhileBaseListener {
 public:
   WhileProgram *Program;
   WhileFunction *CurrentFunction = nullptr;
   WhileBlock *CurrentBlock = nullptr;
 
+  // The blocks of the current function and their instructions, indexed by
+  // block index, while the function's code is generated. The deque keeps the
+  // addresses of blocks stable, which are stored in the parse tree. The code is
+  // laid out in the function's arrays by layoutFunction once it is complete.
+  std::deque<WhileBlock> Blocks;
+  std::vector<std::vector<WhileCodeGenInstr>> Code;
+
   unsigned int FreeRegister;
-  WhileOperand FramePointer;
+  WhileDebugOperand FramePointer;
 
-  WhileCodeGenListener()
-    : Program(new WhileProgram()), FreeRegister(0),
+  explicit WhileCodeGenListener(WhileProgram *program)
+    : Program(program), FreeRegister(0),
       FramePointer(WFRAMEPOINTER)
   {
   }
@@ -69,7 +103,7 @@ public:
     return !sym->AddressTaken && sym->Size == 1;
   }
 
-  std::pair<bool, WhileOperand> registerOfVar(std::string name)
+  std::pair<bool, WhileDebugOperand> registerOfVar(std::string name)
   {
     auto local = CurrentFunction->Locals.find(name);
     if (local != CurrentFunction->Locals.end() && useRegister(local->second))
@@ -77,84 +111,177 @@ public:
       auto reg = CurrentFunction->Registers.find(local->second);
       if(reg != CurrentFunction->Registers.end())
       {
-        return std::pair(true, reg->second);
+        return std::pair(true, WhileDebugOperand(reg->second, local->second));
       }
     }
 
-    return std::pair(false, WhileOperand());;
+    return std::pair(false, WhileDebugOperand());;
   }
 
-  WhileOperand getFunOp(const std::string &name)
+  WhileDebugOperand getFunOp(const std::string &name)
   {
     auto f = Program->Functions.find(name);
     if (f != Program->Functions.end())
-      return WhileOperand(WFUNCTION, f->second.Index, name);
+      return WhileDebugOperand(WFUNCTION, f->second.Index, name);
     else
     {
       auto b = WhileBuiltins.find(name);
       assert(b != WhileBuiltins.end());
-      return WhileOperand(WFUNCTION, b->second.Index, b->first);
+      return WhileDebugOperand(WFUNCTION, b->second.Index, b->first);
     }
     abort();
   }
 
-  WhileOperand getBBOp(const WhileBlock *bb)
+  WhileDebugOperand getBBOp(const WhileBlock *bb)
   {
-    return WhileOperand(WBLOCK, bb->Index);
+    return WhileDebugOperand(WBLOCK, bb->Index);
   }
 
-  WhileOperand getValOp(int value)
+  WhileDebugOperand getValOp(int value)
   {
-    return WhileOperand(WIMMEDIATE, value);
+    return WhileDebugOperand(WIMMEDIATE, value);
   }
 
-  WhileOperand getRegOp()
+  WhileDebugOperand getRegOp()
   {
-    return WhileOperand(WREGISTER, FreeRegister++);
+    return WhileDebugOperand(WREGISTER, FreeRegister++);
   }
 
   WhileBlock *newBlock(bool fallthrough)
   {
     WhileBlock *pred = CurrentBlock;
 
-    CurrentFunction->Body.emplace_back(CurrentFunction->Body.size(),
-                                       CurrentFunction);
-    CurrentBlock = &CurrentFunction->Body.back();
+    Blocks.emplace_back(Blocks.size(), CurrentFunction);
+    Code.emplace_back();
+    CurrentBlock = &Blocks.back();
 
     if (fallthrough)
-    {
-      pred->Succ.emplace(WFALL_THROUGH, CurrentBlock);
-      CurrentBlock->Pred.emplace(pred, WFALL_THROUGH);
-    }
+      pred->Succ[WFALL_THROUGH] = CurrentBlock;
 
     return pred;
   }
 
   void newEdge(WhileBlock *pred, WhileBlock *succ)
   {
-    bool inserted = pred->Succ.emplace(WBRANCH_TAKEN, succ).second;
-    succ->Pred.emplace(pred, WBRANCH_TAKEN);
+    bool inserted = !pred->Succ[WBRANCH_TAKEN];
+    if (inserted)
+      pred->Succ[WBRANCH_TAKEN] = succ;
 
     assert(inserted && "Multiple taken branches");
   }
 
+  // Move the code of the current function into its arrays, see WhileFunction.
+  // The blocks are laid out in the order of their index, the predecessors of
+  // each block are sorted by their index and the kind of their edge. Blocks
+  // and instructions are numbered, and the debug information of the operands
+  // is moved to WhileProgram::OperandInfo.
+  void layoutFunction()
+  {
+    WhileFunction &f = *CurrentFunction;
+
+    unsigned int numInstrs = 0, numCallOps = 0;
+    std::vector<unsigned int> numPreds(Blocks.size());
+    for(const WhileBlock &bb : Blocks)
+    {
+      numInstrs += Code[bb.Index].size();
+      for(const WhileCodeGenInstr &i : Code[bb.Index])
+      {
+        if (i.Ops.size() > WhileOperands::InlineSize)
+          numCallOps += i.Ops.size();
+      }
+
+      for(const auto &[kind, succ] : bb.Succ)
+        numPreds[succ->Index]++;
+    }
+
+    WhileArena &arena = Program->Arena;
+    unsigned int numEdges = std::accumulate(numPreds.begin(), numPreds.end(),
+                                            0u);
+    f.Body.First = f.Body.Last = arena.allocate<WhileBlock>(Blocks.size());
+    f.BlocksByIndex.First = f.BlocksByIndex.Last =
+      arena.allocate<WhileBlock*>(Blocks.size());
+    f.Instrs.First = f.Instrs.Last = arena.allocate<WhileInstr>(numInstrs);
+    f.CallOps.First = f.CallOps.Last = arena.allocate<WhileOperand>(numCallOps);
+    f.Preds.First = arena.allocate<WhileEdge>(numEdges);
+    f.Preds.Last = f.Preds.First + numEdges;
+    for(const WhileBlock &bb : Blocks)
+    {
+      WhileBlock *block = new (f.Body.Last++) WhileBlock(bb.Index, &f);
+      *f.BlocksByIndex.Last++ = block;
+    }
+
+    WhileEdge *preds = f.Preds.First;
+    for(WhileBlock &block : f.Body)
+    {
+      block.Pred.First = block.Pred.Last = preds;
+      preds += numPreds[block.Index];
+    }
 
-  WhileInstr &emitInstr(antlr4::Token *t, WhileOpcode opc,
+    for(WhileBlock &block : f.Body)
+    {
+      block.Id = Program->NumBlocks++;
+      block.Body.First = f.Instrs.Last;
+      const std::vector<WhileCodeGenInstr> &code = Code[block.Index];
+      for(unsigned int index = 0; index < code.size(); index++)
+      {
+        const WhileCodeGenInstr &i = code[index];
+        WhileInstr &instr = *new (f.Instrs.Last++) WhileInstr(index, i.Line,
+                                                              i.OffsetOnLine,
+                                                              i.Opc, &block);
+        instr.Id = Program->NumInstrs++;
+
+        WhileOperand *ops = instr.Ops.Inline;
+        if (i.Ops.size() > WhileOperands::InlineSize)
+        {
+          ops = f.CallOps.Last;
+          f.CallOps.Last += i.Ops.size();
+          instr.Ops.Extra = ops;
+        }
+        instr.Ops.Size = i.Ops.size();
+
+        for(unsigned int idx = 0; idx < i.Ops.size(); idx++)
+        {
+          const WhileDebugOperand &op = i.Ops[idx];
+          ops[idx] = op;
+          if (op.hasDebugInfo())
+            Program->OperandInfo.push_back({instr.Id, idx, op.Symbol,
+                                            op.Comment});
+        }
+      }
+      block.Body.Last = f.Instrs.Last;
+
+      for(const auto &[kind, succ] : Blocks[block.Index].Succ)
+      {
+        WhileBlock *target = &f.Body[succ->Index];
+        block.Succ[kind] = target;
+        new (target->Pred.Last++) WhileEdge(&block, kind);
+      }
+    }
+
+    f.registerCallSites();
+
+    Blocks.clear();
+    Code.clear();
+    CurrentBlock = nullptr;
+  }
+
+
+  WhileCodeGenInstr &emitInstr(antlr4::Token *t, WhileOpcode opc,
                         WhileBlock *block = nullptr)
   {
     if (block == nullptr)
       block = CurrentBlock;
 
-    block->Body.emplace_back(block->Body.size(),
-                             t->getLine(), t->getCharPositionInLine(),
-                             opc, block);
-    return block->Body.back();
+    std::vector<WhileCodeGenInstr> &body = Code[block->Index];
+    body.push_back({(unsigned int)t->getLine(),
+                    (unsigned int)t->getCharPositionInLine(), opc});
+    return body.back();
   }
 
-  WhileInstr &emitStore(antlr4::Token *t, WhileOperand address,
-                        WhileOperand offset, WhileOperand valuetostore)
+  WhileCodeGenInstr &emitStore(antlr4::Token *t, WhileDebugOperand address,
+                        WhileDebugOperand offset, WhileDebugOperand valuetostore)
   {
-    WhileInstr &store = emitInstr(t, WSTORE);
+    WhileCodeGenInstr &store = emitInstr(t, WSTORE);
     store.Ops.emplace_back(address);
     store.Ops.emplace_back(offset);
     store.Ops.emplace_back(valuetostore);
@@ -162,10 +289,10 @@ public:
     return store;
   }
 
-  WhileInstr &emitLoad(antlr4::Token *t, WhileOperand dest,
-                       WhileOperand address, WhileOperand offset)
+  WhileCodeGenInstr &emitLoad(antlr4::Token *t, WhileDebugOperand dest,
+                       WhileDebugOperand address, WhileDebugOperand offset)
   {
-    WhileInstr &load = emitInstr(t, WLOAD);
+    WhileCodeGenInstr &load = emitInstr(t, WLOAD);
     load.Ops.emplace_back(dest);
     load.Ops.emplace_back(address);
     load.Ops.emplace_back(offset);
@@ -173,10 +300,10 @@ public:
     return load;
   }
 
-  WhileInstr &emitBinary(antlr4::Token *t, WhileOpcode opc, WhileOperand dest,
-                         WhileOperand a, WhileOperand b)
+  WhileCodeGenInstr &emitBinary(antlr4::Token *t, WhileOpcode opc, WhileDebugOperand dest,
+                         WhileDebugOperand a, WhileDebugOperand b)
   {
-    WhileInstr &binary = emitInstr(t, opc);
+    WhileCodeGenInstr &binary = emitInstr(t, opc);
     binary.Ops.emplace_back(dest);
     binary.Ops.emplace_back(a);
     binary.Ops.emplace_back(b);
@@ -184,15 +311,16 @@ public:
     return binary;
   }
 
-  WhileInstr &emitPlus(antlr4::Token *t, WhileOperand dest, WhileOperand a,
-                       WhileOperand b)
+  WhileCodeGenInstr &emitPlus(antlr4::Token *t, WhileDebugOperand dest, WhileDebugOperand a,
+                       WhileDebugOperand b)
   {
     return emitBinary(t, WPLUS, dest, a, b);
   }
 
   void emitBranch(antlr4::Token *t, WhileBlock *block, WhileBlock *dest)
   {
-    WhileOpcode lastopc = block->Body.empty() ? WPLUS : block->Body.back().Opc;
+    const std::vector<WhileCodeGenInstr> &body = Code[block->Index];
+    WhileOpcode lastopc = body.empty() ? WPLUS : body.back().Opc;
     switch (lastopc)
     {
       case WRETURN:
@@ -215,7 +343,7 @@ public:
       case WLESS:
       case WLESSEQUAL:
       {
-        WhileInstr &branch = emitInstr(t, WBRANCH, block);
+        WhileCodeGenInstr &branch = emitInstr(t, WBRANCH, block);
         branch.Ops.emplace_back(getBBOp(dest));
         newEdge(block, dest);
         return;
@@ -225,13 +353,13 @@ public:
   }
 
 
-  std::pair<WhileOperand, WhileOperand> getVarAddress(std::string name)
+  std::pair<WhileDebugOperand, WhileDebugOperand> getVarAddress(std::string name)
   {
     auto local = CurrentFunction->Locals.find(name);
     auto global = Program->Globals.find(name);
 
-    WhileOperand base = getValOp(0);
-    WhileOperand offset = getValOp(0);
+    WhileDebugOperand base = getValOp(0);
+    WhileDebugOperand offset = getValOp(0);
     if (local != CurrentFunction->Locals.end())
     {
       assert(CurrentFunction->Registers.find(local->second) == CurrentFunction->Registers.end());
@@ -252,11 +380,11 @@ public:
     return std::pair(base, offset);
   }
 
-  std::pair<WhileOperand, WhileOperand> computeArrayAddr(std::string name,
-      WhileOperand arrayIndex, antlr4::Token *token)
+  std::pair<WhileDebugOperand, WhileDebugOperand> computeArrayAddr(std::string name,
+      WhileDebugOperand arrayIndex, antlr4::Token *token)
   {
     auto [base, offset] = getVarAddress(name);
-    WhileOperand arrayBase;
+    WhileDebugOperand arrayBase;
 
     if (arrayBase.isZero())
       arrayBase = offset;
@@ -281,24 +409,26 @@ public:
 
     newBlock(false);
 
-    for(WhileSymbol &p : ctx->Fun->Parameters.Symbols)
+    CurrentFunction->NumParameters = ctx->Fun->Parameters.Symbols.size();
+    for(const WhileSymbol &param : ctx->Fun->Parameters.Symbols)
     {
-      CurrentFunction->Locals.emplace(p.Name, &p);
-      CurrentFunction->FrameSize += p.Size;
+      WhileSymbol *p = Program->Arena.create<WhileSymbol>(param);
+      CurrentFunction->Locals.emplace(p->Name, p);
+      CurrentFunction->FrameSize += p->Size;
 
-      if (useRegister(&p))
+      if (useRegister(p))
       {
-        WhileOperand reg(getRegOp());
-        reg.Symbol = &p;
-        CurrentFunction->Registers.emplace(&p, reg);
-        emitLoad(ctx->getStart(), reg, FramePointer, getValOp(p.Offset));
+        WhileDebugOperand reg(getRegOp());
+        reg.Symbol = p;
+        CurrentFunction->Registers.emplace(p, reg);
+        emitLoad(ctx->getStart(), reg, FramePointer, getValOp(p->Offset));
       }
     }
   }
 
   virtual void enterVar(WhileParser::VarContext *ctx) override
   {
-    WhileSymbol *sym = ctx->var_def()->Sym;
+    WhileSymbol *sym = Program->Arena.create<WhileSymbol>(*ctx->var_def()->Sym);
 
     Program->Globals.emplace(sym->Name, sym);
     Program->DataSize += sym->Size;
@@ -306,14 +436,14 @@ public:
 
   virtual void exitStmtVar(WhileParser::StmtVarContext *ctx) override
   {
-    WhileSymbol *sym = ctx->var_def()->Sym;
+    WhileSymbol *sym = Program->Arena.create<WhileSymbol>(*ctx->var_def()->Sym);
     antlr4::Token *token = ctx->getStart();
 
     CurrentFunction->Locals.emplace(sym->Name, sym);
     CurrentFunction->FrameSize += sym->Size;
 
     bool usereg = useRegister(sym);
-    WhileOperand reg;
+    WhileDebugOperand reg;
     if(usereg)
     {
       reg = getRegOp();
@@ -330,7 +460,7 @@ public:
       }
       else
       {
-        WhileOperand var(getValOp(sym->Offset + idx));
+        WhileDebugOperand var(getValOp(sym->Offset + idx));
         var.Symbol = sym;
 
         emitStore(token, FramePointer, var, getValOp(value));
@@ -341,7 +471,7 @@ public:
   virtual void exitStmtAssign(WhileParser::StmtAssignContext *ctx) override
   {
     std::string name = ctx->ID()->getText();
-    const WhileOperand &valuetostore = ctx->expr()->Op;
+    const WhileDebugOperand &valuetostore = ctx->expr()->Op;
     antlr4::Token *token = ctx->getStart();
     auto [usereg, regop] = registerOfVar(name);
     if (usereg)
@@ -388,7 +518,7 @@ public:
 
   virtual void exitStmtIf(WhileParser::StmtIfContext *ctx) override
   {
-    if (!CurrentBlock->Body.empty())
+    if (!Code[CurrentBlock->Index].empty())
       newBlock(true);
 
     antlr4::Token *t = ctx->getStart();
@@ -397,7 +527,7 @@ public:
     WhileBlock *bbThenExit = ctx->stmtsThen()->BBThenExit;
     WhileBlock *bbElseEntry = ctx->stmtsElse() ? ctx->stmtsElse()->BBElseEntry : bbEnd;
 
-    WhileInstr &condBranch = emitInstr(t, WBRANCHZ, bbStmt);
+    WhileCodeGenInstr &condBranch = emitInstr(t, WBRANCHZ, bbStmt);
     condBranch.Ops.emplace_back(ctx->expr()->Op);
     condBranch.Ops.emplace_back(getBBOp(bbElseEntry));
     newEdge(bbStmt, bbElseEntry);
@@ -409,7 +539,7 @@ public:
 
   virtual void enterStmtWhile(WhileParser::StmtWhileContext *ctx) override
   {
-    if (!CurrentBlock->Body.empty())
+    if (!Code[CurrentBlock->Index].empty())
       newBlock(true);
 
     ctx->BBStmt = CurrentBlock;
@@ -427,7 +557,7 @@ public:
     emitBranch(t, CurrentBlock, bbStmt);
     newBlock(false);
 
-    WhileInstr &condBranch = emitInstr(t, WBRANCHZ, bbStmt);
+    WhileCodeGenInstr &condBranch = emitInstr(t, WBRANCHZ, bbStmt);
     condBranch.Ops.emplace_back(ctx->expr()->Op);
     condBranch.Ops.emplace_back(getBBOp(CurrentBlock));
     newEdge(bbStmt, CurrentBlock);
@@ -437,7 +567,7 @@ public:
   virtual void exitStmtReturn(WhileParser::StmtReturnContext *ctx) override
   {
     antlr4::Token *t = ctx->getStart();
-    WhileInstr &ret = emitInstr(t, WRETURN);
+    WhileCodeGenInstr &ret = emitInstr(t, WRETURN);
     ret.Ops.emplace_back(ctx->expr()->Op);
   }
 
@@ -462,20 +592,18 @@ public:
   virtual void exitExCall(WhileParser::ExCallContext *ctx) override
   {
     antlr4::Token *t = ctx->getStart();
-    WhileInstr &call = emitInstr(t, WCALL);
-    WhileOperand funop(getFunOp(ctx->ID()->getText()));
+    WhileCodeGenInstr &call = emitInstr(t, WCALL);
+    WhileDebugOperand funop(getFunOp(ctx->ID()->getText()));
     call.Ops.emplace_back(funop);
     call.Ops.emplace_back(ctx->Op = getRegOp());
 
     for(const WhileParser::ExprContext*ex : ctx->call_args()->expr())
       call.Ops.emplace_back(ex->Op);
 
-    if (0 <= funop.ValueOrIndex)
-    {
-      Program->FunctionsByIndex.at(funop.ValueOrIndex)
-        ->CallSites.emplace_back(&call);
-    }
+    CurrentFunction->MaxCallArgs = std::max<unsigned int>(
+        CurrentFunction->MaxCallArgs, call.Ops.size() - 2);
 
+    // the call is added to the callee's call sites by layoutFunction.
     newBlock(true);
   }
 
@@ -581,8 +709,10 @@ public:
 
   virtual void exitFun_def(WhileParser::Fun_defContext *ctx) override
   {
-    WhileOpcode lastopc = CurrentBlock->Body.empty() ? WPLUS :
-                                                  CurrentBlock->Body.back().Opc;
+    CurrentFunction->NumRegisters = FreeRegister;
+
+    const std::vector<WhileCodeGenInstr> &body = Code[CurrentBlock->Index];
+    WhileOpcode lastopc = body.empty() ? WPLUS : body.back().Opc;
     switch (lastopc)
     {
       case WRETURN:
@@ -605,10 +735,12 @@ public:
       case WLESSEQUAL:
       {
         antlr4::Token *t = ctx->getStop();
-        WhileInstr &ret = emitInstr(t, WRETURN);
+        WhileCodeGenInstr &ret = emitInstr(t, WRETURN);
         ret.Ops.emplace_back(getValOp(0));
       }
     }
+
+    layoutFunction();
   }
 };
 
@@ -644,21 +776,27 @@ std::ostream &WhileInstr::dump(std::ostream &s) const
   }
   s << std::left << std::setw(20) << tmp.str() << std::right << " # " << Line << ":" << OffsetOnLine;
 
+  const std::vector<WhileOperandInfo> &info = Block->Function->Program->OperandInfo;
+  auto op = std::lower_bound(info.begin(), info.end(), Id,
+                             [](const WhileOperandInfo &o, unsigned int id) {
+                               return o.Instr < id;
+                             });
+
   first = true;
-  for (const WhileOperand &op : Ops)
+  for (; op != info.end() && op->Instr == Id; op++)
   {
-    if (op.Symbol)
+    if (op->Symbol)
     {
       if (first)
         s << ":";
-      s << " " << op.Symbol->Name;
+      s << " " << op->Symbol->Name;
       first = false;
     }
-    if (!op.Comment.empty())
+    if (!op->Comment.empty())
     {
       if (first)
         s << ":";
-      s << " " << op.Comment;
+      s << " " << op->Comment;
       first = false;
     }
   }
@@ -684,7 +822,7 @@ std::ostream &WhileBlock::dumphead(std::ostream &s) const
   }
   s << "] -> [";
   first = true;
-  for(auto &[kind, succ] : Succ)
+  for(const auto &[kind, succ] : Succ)
   {
     if (!first)
       s << ", ";
@@ -707,6 +845,18 @@ std::ostream &WhileBlock::dump(std::ostream &s) const
   return s;
 }
 
+void WhileFunction::registerCallSites()
+{
+  for(WhileInstr &i : Instrs)
+  {
+    if (i.Opc == WCALL && 0 <= i.Ops[0].ValueOrIndex)
+    {
+      Program->FunctionsByIndex.at(i.Ops[0].ValueOrIndex)
+        ->CallSites.emplace_back(&i);
+    }
+  }
+}
+
 std::ostream &WhileFunction::dumpshort(std::ostream &s) const
 {
   return s << "fun " << Index << ": " << Name;
@@ -784,10 +934,11 @@ std::ostream &WhileProgram::dump(std::ostream &s) const
 }
 
 
-WhileProgram *generateCode(antlr4::tree::ParseTree *tree)
+std::unique_ptr<WhileProgram> generateCode(antlr4::tree::ParseTree *tree)
 {
-  WhileCodeGenListener WCGL;
+  std::unique_ptr<WhileProgram> program = std::make_unique<WhileProgram>();
+  WhileCodeGenListener WCGL(program.get());
   antlr4::tree::ParseTreeWalker::DEFAULT.walk(&WCGL, tree);
 
-  return WCGL.Program;
+  return program;
 }
@@ -0,0 +1,221 @@
+// This file is part of While, an educational programming language and program
+// analysis framework.
+//
+//   Copyright 2023 Florian Brandner
+//
+// While is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// While is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+// A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// While. If not, see <https://www.gnu.org/licenses/>.
+//
+// Contact: florian.brandner@telecom-paris.fr
+//
+
+// The on-disk cache of compiled programs and analysis results, see
+// WhileCache.h.
+
+#include "WhileCache.h"
+#include "WhileBinary.h"
+#include "WhileBuildId.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// Changes whenever the layout of the cache changes. Changes of the tools are
+// covered by WHILE_BUILD_ID, a hash of their sources computed by the build.
+static const char *WhileCacheVersion = "while-cache-2";
+
+// Temporary files older than this are left over from crashed processes.
+static const auto WhileCacheStaleTime = std::chrono::hours(1);
+
+// 64-bit FNV-1a hash.
+static uint64_t hash(const std::string &data, uint64_t h = 0xcbf29ce484222325)
+{
+  for(unsigned char c : data)
+  {
+    h ^= c;
+    h *= 0x100000001b3;
+  }
+  return h;
+}
+
+static std::string hex(uint64_t h)
+{
+  std::ostringstream s;
+  s << std::hex;
+  s.width(16);
+  s.fill('0');
+  s << h;
+  return s.str();
+}
+
+static std::string cacheDir()
+{
+  if (const char *dir = std::getenv("WHILE_CACHE_DIR"))
+    return dir;
+  if (const char *dir = std::getenv("XDG_CACHE_HOME"))
+    return std::string(dir) + "/while";
+  if (const char *dir = std::getenv("HOME"))
+    return std::string(dir) + "/.cache/while";
+  return "";
+}
+
+std::unique_ptr<WhileCache> WhileCache::open(const std::string &filename)
+{
+  std::ifstream in(filename, std::ios::binary);
+  std::ostringstream source;
+  std::string dir = cacheDir();
+  if (!in || !(source << in.rdbuf()) || dir.empty())
+    return nullptr;
+
+  std::error_code ec;
+  fs::create_directories(dir, ec);
+  if (ec)
+    return nullptr;
+
+  uint64_t maxsize = DefaultSize;
+  if (const char *size = std::getenv("WHILE_CACHE_SIZE"))
+    maxsize = std::strtoull(size, nullptr, 10);
+
+  std::string tool = std::string(WhileCacheVersion) + " " + WHILE_BUILD_ID;
+  std::string key = hex(hash(source.str(), hash(tool)));
+  return std::unique_ptr<WhileCache>(new WhileCache(dir, key,
+                                                    maxsize << 20));
+}
+
+std::string WhileCache::path(const std::string &entry) const
+{
+  return Dir + "/" + Key + "-" + hex(hash(entry)) + ".wc";
+}
+
+void WhileCache::touch(const std::string &file) const
+{
+  std::error_code ec;
+  fs::last_write_time(file, fs::file_time_type::clock::now(), ec);
+}
+
+template<typename F>
+void WhileCache::store(const std::string &entry, F write)
+{
+  // Temporary files are named by a random number per process and a counter.
+  static const std::string process = hex(std::random_device()());
+  static std::atomic<unsigned int> counter(0);
+
+  std::string file = path(entry);
+  std::string tmp = file + ".tmp" + process + "." + std::to_string(counter++);
+  std::ofstream out(tmp, std::ios::binary);
+  bool keep = out && write(out);
+  out.close();
+
+  // Entries larger than the whole cache are not kept, they would only evict
+  // all other entries.
+  std::error_code ec;
+  keep = keep && !out.fail() && fs::file_size(tmp, ec) <= MaxSize && !ec;
+  if (keep)
+    fs::rename(tmp, file, ec);
+
+  if (!keep || ec)
+    fs::remove(tmp, ec);
+  else
+    evict();
+}
+
+void WhileCache::evict() const
+{
+  struct Entry
+  {
+    fs::file_time_type Time;
+    uint64_t Size;
+    fs::path Path;
+  };
+
+  std::error_code ec;
+  std::vector<Entry> entries;
+  uint64_t total = 0;
+  auto now = fs::file_time_type::clock::now();
+  for(const fs::directory_entry &e : fs::directory_iterator(Dir, ec))
+  {
+    std::error_code tec, sec;
+    fs::file_time_type time = e.last_write_time(tec);
+    uint64_t size = e.file_size(sec);
+    if (tec || sec)
+      continue;
+
+    // Temporary files of other processes are not yet part of the cache.
+    bool tmp = e.path().filename().string().find(".tmp") != std::string::npos;
+    if (tmp && now - time < WhileCacheStaleTime)
+      continue;
+
+    entries.push_back({tmp ? fs::file_time_type::min() : time, size,
+                       e.path()});
+    total += size;
+  }
+
+  if (total <= MaxSize)
+    return;
+
+  std::sort(entries.begin(), entries.end(),
+            [](const Entry &a, const Entry &b) { return a.Time < b.Time; });
+  for(const Entry &e : entries)
+  {
+    if (total <= MaxSize)
+      break;
+
+    // Removing an entry does not affect processes that are still using it.
+    if (fs::remove(e.Path, ec))
+      total -= e.Size;
+  }
+}
+
+std::unique_ptr<WhileProgram> WhileCache::loadProgram() const
+{
+  std::string file = path("program");
+  std::unique_ptr<WhileProgram> p = readBinaryProgram(file, true);
+  if (p)
+    touch(file);
+  return p;
+}
+
+void WhileCache::storeProgram(const WhileProgram &p)
+{
+  store("program", [&p](std::ostream &out) {
+    return writeBinaryProgram(out, p);
+  });
+}
+
+bool WhileCache::load(const std::string &entry, std::string &text) const
+{
+  std::string file = path(entry);
+  std::ifstream in(file, std::ios::binary);
+  std::ostringstream s;
+  if (!in || !(s << in.rdbuf()))
+    return false;
+
+  text = s.str();
+  touch(file);
+  return true;
+}
+
+void WhileCache::store(const std::string &entry, const std::string &text)
+{
+  store(entry, [&text](std::ostream &out) {
+    out.write(text.data(), text.size());
+    return out.good();
+  });
+}
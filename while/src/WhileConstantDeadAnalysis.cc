@@ -52,7 +52,7 @@ struct WhileConstantValue
   }
 };
 
-typedef std::map<int, WhileConstantValue> WhileConstantDomain;
+typedef WhileRegisterMap<WhileConstantValue> WhileConstantDomain;
 
 enum WhileReachability
 {
@@ -105,15 +105,20 @@ bool operator!=(const WhileConstantDeadValue &a, const WhileConstantDeadValue &b
   return !(a == b);
 }
 
-struct WhileConstant : public WhileDataFlowAnalysis<WhileConstantDeadValue>
+struct WhileConstant
+  : public WhileByValueAnalysis<WhileDataFlowAnalysis<WhileConstantDeadValue>>
 {
   std::ostream &dump_first(std::ostream &s,
                            const WhileConstantDeadValue &value) override
   {
     s << "    [";
     bool first = true;
-    for(const auto&[idx, c] : value.WConstant)
+    for(unsigned int idx = 0; idx < value.WConstant.size(); idx++)
     {
+      if (!value.WConstant.contains(idx))
+        continue;
+
+      const WhileConstantValue &c = value.WConstant[idx];
       if (!first)
         s << ", ";
 
@@ -192,11 +197,10 @@ struct WhileConstant : public WhileDataFlowAnalysis<WhileConstantDeadValue>
       case WREGISTER:
       {
         assert(op.ValueOrIndex >= 0);
-        auto value = input.WConstant.find(op.ValueOrIndex);
-        if (value == input.WConstant.end())
+        if (!input.WConstant.contains(op.ValueOrIndex))
           return BOTTOM; // register undefined
         else
-          return value->second;
+          return input.WConstant[op.ValueOrIndex];
       }
       case WIMMEDIATE:
         return op.ValueOrIndex;
@@ -399,10 +403,15 @@ struct WhileConstant : public WhileDataFlowAnalysis<WhileConstantDeadValue>
       result.WReachability = DEAD;
     } else {
       
-    for(WhileConstantDeadValue r : inputs)
+    for(const WhileConstantDeadValue &r : inputs)
     {
-      for(const auto&[idx, value] : r.WConstant)
-      { // TODO : Verify next condition !!! 
+      for(unsigned int idx = 0; idx < r.WConstant.size(); idx++)
+      {
+        if (!r.WConstant.contains(idx))
+          continue;
+
+        const WhileConstantValue &value = r.WConstant[idx];
+        // TODO : Verify next condition !!! 
         // it appers to be ok, for the example ( the bb {x = 9;} won't be reachable
         // so the value 9, won't be taken into account )
         if ( r.WReachability == REACHABLE || r.WReachabilityTakenBranch == REACHABLE){
@@ -427,10 +436,10 @@ struct WhileConstant : public WhileDataFlowAnalysis<WhileConstantDeadValue>
   WhileConstantDeadValue join(const WhileBlock *bb) override {
     std::list<WhileConstantDeadValue> bbIn;
     for(const auto &[pred, kind] : bb->Pred){
-      if(kind == WFALL_THROUGH && BBOut[pred].WReachability == REACHABLE)
-        bbIn.emplace_back(BBOut[pred]);
-      else if(kind == WBRANCH_TAKEN && BBOut[pred].WReachabilityTakenBranch == REACHABLE)
-        bbIn.emplace_back(BBOut[pred]);
+      if(kind == WFALL_THROUGH && readBBOut(pred).WReachability == REACHABLE)
+        bbIn.emplace_back(readBBOut(pred));
+      else if(kind == WBRANCH_TAKEN && readBBOut(pred).WReachabilityTakenBranch == REACHABLE)
+        bbIn.emplace_back(readBBOut(pred));
     }
     // indicate reachability of the current basic block bb
     WhileConstantDeadValue wcdv = join(bbIn); 
@@ -445,11 +454,12 @@ struct WhileConstant : public WhileDataFlowAnalysis<WhileConstantDeadValue>
 
 struct WhileConstantDeadValueAnalysis : public WhileAnalysis
 {
-  void analyze(const WhileProgram &p) override
+  void analyze(const WhileProgram &p, std::ostream &s) override
   {
     WhileConstant WCDA;
-    WCDA.analyze(p);
-    WCDA.dump(std::cout, p);
+    analyzeParallel(WCDA, p, Threads);
+    Stats = WCDA.Stats;
+    WCDA.dump(s, p);
   };
 
   WhileConstantDeadValueAnalysis() : WhileAnalysis("WCDA",
@@ -57,7 +57,7 @@ bool operator==(const WhileConstantValue &a, const WhileConstantValue &b)
   return (a.Kind == b.Kind && a.Value == b.Value);
 }
 
-typedef std::map<int, WhileConstantValue> WhileConstantDomain;
+typedef WhileRegisterMap<WhileConstantValue> WhileConstantDomain;
 
 std::ostream &operator<<(std::ostream &s, const WhileConstantValue &v)
 {
@@ -80,8 +80,12 @@ struct WhileConstant : public WhileDataFlowAnalysis<WhileConstantDomain>
   {
     s << "    [";
     bool first = true;
-    for(const auto&[idx, c] : value)
+    for(unsigned int idx = 0; idx < value.size(); idx++)
     {
+      if (!value.contains(idx))
+        continue;
+
+      const WhileConstantValue &c = value[idx];
       if (!first)
         s << ", ";
 
@@ -135,11 +139,10 @@ struct WhileConstant : public WhileDataFlowAnalysis<WhileConstantDomain>
       case WREGISTER:
       {
         assert(op.ValueOrIndex >= 0);
-        auto value = input.find(op.ValueOrIndex);
-        if (value == input.end())
+        if (!input.contains(op.ValueOrIndex))
           return BOTTOM; // register undefined
         else
-          return value->second;
+          return input[op.ValueOrIndex];
       }
       case WIMMEDIATE:
         return op.ValueOrIndex;
@@ -155,9 +158,9 @@ struct WhileConstant : public WhileDataFlowAnalysis<WhileConstantDomain>
     abort();
   }
 
-  WhileConstantDomain transfer(const WhileInstr &instr, const WhileConstantDomain input) override
+  void transferInPlace(const WhileInstr &instr,
+                       WhileConstantDomain &value) override
   {
-    WhileConstantDomain result = input;
     const auto &ops = instr.Ops;
     switch(instr.Opc)
     {
@@ -172,7 +175,7 @@ struct WhileConstant : public WhileDataFlowAnalysis<WhileConstantDomain>
       {
         // Ops: Fun Opd = Arg1, Arg2, ... ArgN
         assert(ops.size() > 2);
-        updateRegisterOperand(instr, 1, result, BOTTOM);
+        updateRegisterOperand(instr, 1, value, BOTTOM);
         break;
       }
 
@@ -180,7 +183,7 @@ struct WhileConstant : public WhileDataFlowAnalysis<WhileConstantDomain>
       {
         // Ops: OpD = [BaseAddress + Offset]
         assert(ops.size() ==  3);
-        updateRegisterOperand(instr, 0, result, BOTTOM);
+        updateRegisterOperand(instr, 0, value, BOTTOM);
         break;
       }
 
@@ -188,109 +191,107 @@ struct WhileConstant : public WhileDataFlowAnalysis<WhileConstantDomain>
       {
         // Ops: OpD = OpA + OpB
         assert(ops.size() ==  3);
-        WhileConstantValue a = readDataOperand(instr, 1, input);
-        WhileConstantValue b = readDataOperand(instr, 2, input);
+        WhileConstantValue a = readDataOperand(instr, 1, value);
+        WhileConstantValue b = readDataOperand(instr, 2, value);
 
         if (a.Kind == CONSTANT && b.Kind == CONSTANT)
-          updateRegisterOperand(instr, 0, result, a.Value + b.Value);
+          updateRegisterOperand(instr, 0, value, a.Value + b.Value);
         else
-          updateRegisterOperand(instr, 0, result, BOTTOM);
+          updateRegisterOperand(instr, 0, value, BOTTOM);
         break;
       }
       case WMINUS:
       {
         // Ops: OpD = OpA - OpB
         assert(ops.size() ==  3);
-        WhileConstantValue a = readDataOperand(instr, 1, input);
-        WhileConstantValue b = readDataOperand(instr, 2, input);
+        WhileConstantValue a = readDataOperand(instr, 1, value);
+        WhileConstantValue b = readDataOperand(instr, 2, value);
 
         if (a.Kind == CONSTANT && b.Kind == CONSTANT)
-          updateRegisterOperand(instr, 0, result, a.Value - b.Value);
+          updateRegisterOperand(instr, 0, value, a.Value - b.Value);
         else
-          updateRegisterOperand(instr, 0, result, BOTTOM);
+          updateRegisterOperand(instr, 0, value, BOTTOM);
         break;
       }
       case WMULT:
       {
         // Ops: OpD = OpA * OpB
         assert(ops.size() ==  3);
-        WhileConstantValue a = readDataOperand(instr, 1, input);
-        WhileConstantValue b = readDataOperand(instr, 2, input);
+        WhileConstantValue a = readDataOperand(instr, 1, value);
+        WhileConstantValue b = readDataOperand(instr, 2, value);
 
         if (a.Kind == CONSTANT && b.Kind == CONSTANT)
-          updateRegisterOperand(instr, 0, result, a.Value * b.Value);
+          updateRegisterOperand(instr, 0, value, a.Value * b.Value);
         else
-          updateRegisterOperand(instr, 0, result, BOTTOM);
+          updateRegisterOperand(instr, 0, value, BOTTOM);
         break;
       }
       case WDIV:
       {
         // Ops: OpD = OpA / OpB
         assert(ops.size() ==  3);
-        WhileConstantValue a = readDataOperand(instr, 1, input);
-        WhileConstantValue b = readDataOperand(instr, 2, input);
+        WhileConstantValue a = readDataOperand(instr, 1, value);
+        WhileConstantValue b = readDataOperand(instr, 2, value);
 
         if (a.Kind == CONSTANT && b.Kind == CONSTANT)
-          updateRegisterOperand(instr, 0, result, a.Value / b.Value);
+          updateRegisterOperand(instr, 0, value, a.Value / b.Value);
         else
-          updateRegisterOperand(instr, 0, result, BOTTOM);
+          updateRegisterOperand(instr, 0, value, BOTTOM);
         break;
       }
       case WEQUAL:
       {
         // Ops: OpD = OpA == OpB
         assert(ops.size() ==  3);
-        WhileConstantValue a = readDataOperand(instr, 1, input);
-        WhileConstantValue b = readDataOperand(instr, 2, input);
+        WhileConstantValue a = readDataOperand(instr, 1, value);
+        WhileConstantValue b = readDataOperand(instr, 2, value);
 
         if (a.Kind == CONSTANT && b.Kind == CONSTANT)
-          updateRegisterOperand(instr, 0, result, a.Value == b.Value);
+          updateRegisterOperand(instr, 0, value, a.Value == b.Value);
         else
-          updateRegisterOperand(instr, 0, result, BOTTOM);
+          updateRegisterOperand(instr, 0, value, BOTTOM);
         break;
       }
       case WUNEQUAL:
       {
         // Ops: OpD = OpA != OpB
         assert(ops.size() ==  3);
-        WhileConstantValue a = readDataOperand(instr, 1, input);
-        WhileConstantValue b = readDataOperand(instr, 2, input);
+        WhileConstantValue a = readDataOperand(instr, 1, value);
+        WhileConstantValue b = readDataOperand(instr, 2, value);
 
         if (a.Kind == CONSTANT && b.Kind == CONSTANT)
-          updateRegisterOperand(instr, 0, result, a.Value != b.Value);
+          updateRegisterOperand(instr, 0, value, a.Value != b.Value);
         else
-          updateRegisterOperand(instr, 0, result, BOTTOM);
+          updateRegisterOperand(instr, 0, value, BOTTOM);
         break;
       }
       case WLESS:
       {
         // Ops: OpD = OpA < OpB
         assert(ops.size() ==  3);
-        WhileConstantValue a = readDataOperand(instr, 1, input);
-        WhileConstantValue b = readDataOperand(instr, 2, input);
+        WhileConstantValue a = readDataOperand(instr, 1, value);
+        WhileConstantValue b = readDataOperand(instr, 2, value);
 
         if (a.Kind == CONSTANT && b.Kind == CONSTANT)
-          updateRegisterOperand(instr, 0, result, a.Value < b.Value);
+          updateRegisterOperand(instr, 0, value, a.Value < b.Value);
         else
-          updateRegisterOperand(instr, 0, result, BOTTOM);
+          updateRegisterOperand(instr, 0, value, BOTTOM);
         break;
       }
       case WLESSEQUAL:
       {
         // Ops: OpD = OpA <= OpB
         assert(ops.size() ==  3);
-        WhileConstantValue a = readDataOperand(instr, 1, input);
-        WhileConstantValue b = readDataOperand(instr, 2, input);
+        WhileConstantValue a = readDataOperand(instr, 1, value);
+        WhileConstantValue b = readDataOperand(instr, 2, value);
 
         if (a.Kind == CONSTANT && b.Kind == CONSTANT)
-          updateRegisterOperand(instr, 0, result, a.Value <= b.Value);
+          updateRegisterOperand(instr, 0, value, a.Value <= b.Value);
         else
-          updateRegisterOperand(instr, 0, result, BOTTOM);
+          updateRegisterOperand(instr, 0, value, BOTTOM);
         break;
       }
     };
-
-    return result;
   }
 
   static WhileConstantValue join(const WhileConstantValue &a,
@@ -306,30 +307,29 @@ struct WhileConstant : public WhileDataFlowAnalysis<WhileConstantDomain>
       return BOTTOM;
   }
 
-  WhileConstantDomain join(std::list<WhileConstantDomain> inputs) override
+  void joinInto(WhileConstantDomain &result,
+                const WhileConstantDomain &input) override
   {
-    WhileConstantDomain result;
-    for(WhileConstantDomain r : inputs)
+    for(unsigned int idx = 0; idx < input.size(); idx++)
     {
-      for(const auto&[idx, value] : r)
-      {
-        WhileConstantValue &resultvalue = result[idx];
-        resultvalue = join(resultvalue, value);
-      }
-    }
+      if (!input.contains(idx))
+        continue;
 
-    return result;
+      WhileConstantValue &resultvalue = result[idx];
+      resultvalue = join(resultvalue, input[idx]);
+    }
   }
 };
 
 
 struct WhileConstantRegisterAnalysis : public WhileAnalysis
 {
-  void analyze(const WhileProgram &p) override
+  void analyze(const WhileProgram &p, std::ostream &s) override
   {
     WhileConstant WCRA;
-    WCRA.analyze(p);
-    WCRA.dump(std::cout, p);
+    analyzeParallel(WCRA, p, Threads);
+    Stats = WCRA.Stats;
+    WCRA.dump(s, p);
   };
 
   WhileConstantRegisterAnalysis() : WhileAnalysis("WCRA",
@@ -44,7 +44,8 @@ std::ostream &operator<<(std::ostream &s, WhileReachability r)
   abort();
 }
 
-struct WhileDeadCode : public WhileDataFlowAnalysis<WhileReachability>
+struct WhileDeadCode
+  : public WhileByValueAnalysis<WhileDataFlowAnalysis<WhileReachability>>
 {
   std::ostream &dump_first(std::ostream &s,
                            const WhileReachability &value) override
@@ -120,11 +121,12 @@ struct WhileDeadCode : public WhileDataFlowAnalysis<WhileReachability>
 
 struct WhileDeadCodeAnalysis : public WhileAnalysis
 {
-  void analyze(const WhileProgram &p) override
+  void analyze(const WhileProgram &p, std::ostream &s) override
   {
     WhileDeadCode WDCA;
-    WDCA.analyze(p);
-    WDCA.dump(std::cout, p);
+    analyzeParallel(WDCA, p, Threads);
+    Stats = WDCA.Stats;
+    WDCA.dump(s, p);
   };
 
   WhileDeadCodeAnalysis() : WhileAnalysis("WDCA", "Dead Code Analysis")
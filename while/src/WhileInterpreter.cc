@@ -24,8 +24,57 @@
 // instruction, stack-, and frame-pointer.
 
 #include "WhileInterpreter.h"
+#include "WhileTrace.h"
+#include "WhileProfile.h"
 
 #include <cassert>
+#include <new>
+
+#if WHILE_MMAP_MEMORY
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+WhileMemory::WhileMemory(unsigned int size) : Size(size)
+{
+#if WHILE_MMAP_MEMORY
+  std::size_t page = sysconf(_SC_PAGESIZE);
+  auto pages = [page](std::size_t bytes) {
+    return (bytes + page - 1) / page * page;
+  };
+  std::size_t guard = pages(GuardSize * sizeof(int));
+  std::size_t data = pages(std::size_t(size) * sizeof(int));
+
+  // Reserve the entire region inaccessible, then open up the data pages. The
+  // kernel commits zero-filled pages on first touch.
+  RegionSize = guard + data + guard;
+  Region = mmap(nullptr, RegionSize, PROT_NONE,
+                MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  if (Region == MAP_FAILED)
+    throw std::bad_alloc();
+
+  char *start = static_cast<char*>(Region) + guard;
+  if (data != 0 && mprotect(start, data, PROT_READ | PROT_WRITE) != 0)
+  {
+    munmap(Region, RegionSize);
+    throw std::bad_alloc();
+  }
+  Base = reinterpret_cast<int*>(start);
+#else
+  RegionSize = (GuardSize + std::size_t(size) + GuardSize) * sizeof(int);
+  Region = new int[GuardSize + std::size_t(size) + GuardSize]();
+  Base = static_cast<int*>(Region) + GuardSize;
+#endif
+}
+
+WhileMemory::~WhileMemory()
+{
+#if WHILE_MMAP_MEMORY
+  munmap(Region, RegionSize);
+#else
+  delete[] static_cast<int*>(Region);
+#endif
+}
 
 int WhilePrintInt(WhileState &s, std::vector<int> &ops)
 {
@@ -47,10 +96,10 @@ int WhilePrintString(WhileState &s, std::vector<int> &ops)
   unsigned int ptr = ops.front();
   while(true)
   {
-    if (ptr > s.Memory.size())
+    if (!s.Memory.contains(ptr))
       return -1;
 
-    char c = s.Memory.at(ptr);
+    char c = s.Memory[ptr];
     ptr++;
     if (c)
       std::cout << c;
@@ -73,21 +122,42 @@ WhileState::WhileState(const WhileProgram *program, unsigned int stacksize)
   const auto main = Program->Functions.find("main");
   if (main != Program->Functions.end())
   {
-    const WhileBlock &entryBB = main->second.Body.front();
+    Context.reserve(64);
+    pushContext(&main->second, program->DataSize);
 
-    Context.emplace_back(&main->second, &entryBB, entryBB.Body.begin(), program->DataSize);
+    unsigned int maxArgs = 0;
+    for(const auto &[n, f] : Program->Functions)
+      maxArgs = std::max(maxArgs, f.MaxCallArgs);
+    BuiltinArgs.reserve(maxArgs);
 
     for(auto [n, g] : Program->Globals)
     {
       unsigned int idx = 0;
       for(int value : g->Init)
       {
-        Memory.at(g->Offset + idx++) = value;
+        Memory[g->Offset + idx++] = value;
       }
     }
   }
 }
 
+void WhileState::pushContext(const WhileFunction *fun, unsigned int fp)
+{
+  const WhileBlock &entryBB = fun->Body.front();
+  unsigned int base = Registers.size();
+
+  Context.emplace_back(fun, &entryBB, entryBB.Body.begin(), fp, base);
+  Registers.resize(base + fun->NumRegisters);
+
+  updateStats(Context.size(), Registers.size());
+}
+
+void WhileState::popContext()
+{
+  Registers.resize(Context.back().RegisterBase);
+  Context.pop_back();
+}
+
 int WhileState::readDataOperand(const WhileInstr &i, unsigned int idx) const
 {
   const WhileOperand &op = i.Ops[idx];
@@ -97,7 +167,7 @@ int WhileState::readDataOperand(const WhileInstr &i, unsigned int idx) const
     case WFRAMEPOINTER:
       return ctx.FramePointer;
     case WREGISTER:
-      return ctx.Registers[op.ValueOrIndex];
+      return Registers[ctx.RegisterBase + op.ValueOrIndex];
     case WIMMEDIATE:
       return op.ValueOrIndex;
 
@@ -137,12 +207,7 @@ const WhileBlock *WhileState::readBBOperand(const WhileInstr &i,
   {
     case WBLOCK:
       if (op.ValueOrIndex < 0) return nullptr;
-      else
-      {
-        auto it = ctx.Function->Body.cbegin();
-        std::advance(it, op.ValueOrIndex);
-        return &*it;
-      }
+      else return ctx.Function->BlocksByIndex.at(op.ValueOrIndex);
 
     case WFUNCTION:
     case WFRAMEPOINTER:
@@ -162,10 +227,9 @@ void WhileState::writeRegisterOperand(const WhileInstr &i, unsigned int idx,
   switch (op.Kind)
   {
     case WREGISTER:
-      assert(op.ValueOrIndex >= 0);
-      if (ctx.Registers.size() <= (unsigned int)op.ValueOrIndex)
-        ctx.Registers.resize(op.ValueOrIndex+1);
-      ctx.Registers[op.ValueOrIndex] = value;
+      assert(op.ValueOrIndex >= 0 &&
+             (unsigned int)op.ValueOrIndex < ctx.Function->NumRegisters);
+      Registers[ctx.RegisterBase + op.ValueOrIndex] = value;
       return;
 
     case WIMMEDIATE:
@@ -178,7 +242,8 @@ void WhileState::writeRegisterOperand(const WhileInstr &i, unsigned int idx,
   abort();
 }
 
-void WhileState::step(bool trace)
+template<typename T>
+void WhileState::step(T &trace)
 {
   if (Context.empty())
   {
@@ -190,26 +255,16 @@ void WhileState::step(bool trace)
 
   const WhileBlock *block = ctx.Block;
   const auto &body = block->Body;
-  if (ctx.InstructionPointer == body.cend())
+  if (ctx.InstructionPointer == body.end())
   {
-    ctx.Block = block->Succ.at(WFALL_THROUGH);
-    ctx.InstructionPointer = ctx.Block->Body.cbegin();
+    ctx.Block = block->Succ[WFALL_THROUGH];
+    ctx.InstructionPointer = ctx.Block->Body.begin();
   }
 
   const WhileInstr &instr = *ctx.InstructionPointer;
   const auto &ops = instr.Ops;
 
-  if (trace)
-  {
-    std::cout << ctx.Function->Name << "(" << ctx.Function->Index << ")::"
-              << ctx.Block->Index << "::"
-              << ctx.InstructionPointer->Index
-              << ": ";
-    instr.dump(std::cout);
-
-    std::cout << " FP=" << ctx.FramePointer
-              << " SP=" << ctx.FramePointer + ctx.Function->FrameSize;
-  }
+  trace.begin(ctx, instr);
 
   ctx.InstructionPointer++;
 
@@ -224,36 +279,48 @@ void WhileState::step(bool trace)
 
       if (fun)
       {
-        const WhileBlock &entryBB = fun->Body.front();
         unsigned int nextFP = ctx.FramePointer + ctx.Function->FrameSize;
 
+        if (nextFP > Memory.size() || fun->FrameSize > Memory.size() - nextFP)
+        {
+          std::vector<const WhileInstr *> calls;
+          for(auto c = Context.rbegin(); c != Context.rend(); c++)
+            calls.emplace_back(c->LastCall);
+
+          reportStackOverflow(calls, fun);
+          break;
+        }
+
+        // arguments are stored at the beginning of the callee's frame.
+        unsigned int numArgs = ops.size() - 2;
+        if (Checked && numArgs && !Memory.contains(nextFP + numArgs - 1))
+        {
+          reportMemoryFault(instr, nextFP + numArgs - 1);
+          break;
+        }
+
         for(unsigned int i = 2; i < ops.size(); i++)
-          Memory.at(nextFP + i - 2) = readDataOperand(instr, i);
+          Memory[nextFP + i - 2] = readDataOperand(instr, i);
 
-        Context.emplace_back(fun, &entryBB, entryBB.Body.begin(), nextFP);
+        // invalidates ctx
+        pushContext(fun, nextFP);
+        trace.enter(*fun);
       }
       else
       {
-        std::vector<int> args;
-        for(unsigned int i = 2; i < ops.size(); i++)
-          args.emplace_back(readDataOperand(instr, i));
-
-        bool found = false;
-        for(const auto[n, b] : WhileBuiltins)
-        {
-          if (b.Index == ops[0].ValueOrIndex)
-          {
-            int result = b.Function(*this, args);
-            writeRegisterOperand(instr, 1, result);
-            found = true;
-            break;
-          }
-        }
-        if (!found)
+        const WhileBuiltin *b = getBuiltin(ops[0].ValueOrIndex);
+        if (!b)
         {
           assert("Unexpected builtin.");
           abort();
         }
+
+        BuiltinArgs.clear();
+        for(unsigned int i = 2; i < ops.size(); i++)
+          BuiltinArgs.emplace_back(readDataOperand(instr, i));
+
+        int result = b->Function(*this, BuiltinArgs);
+        writeRegisterOperand(instr, 1, result);
       }
       break;
     }
@@ -264,9 +331,14 @@ void WhileState::step(bool trace)
       int base = readDataOperand(instr, 1);
       int offset = readDataOperand(instr, 2);
 
-      int result = Memory.at(base + offset);
-      if (trace)
-        std::cout << " writes " << result;
+      if (Checked && !Memory.contains(base + offset))
+      {
+        reportMemoryFault(instr, base + offset);
+        break;
+      }
+
+      int result = Memory[base + offset];
+      trace.event(WTRACE_WRITES, result);
 
       writeRegisterOperand(instr, 0, result);
       break;
@@ -279,10 +351,15 @@ void WhileState::step(bool trace)
       int offset = readDataOperand(instr, 1);
       int value = readDataOperand(instr, 2);
 
-      if (trace)
-        std::cout << " writes " << value;
+      if (Checked && !Memory.contains(base + offset))
+      {
+        reportMemoryFault(instr, base + offset);
+        break;
+      }
+
+      trace.event(WTRACE_WRITES, value);
 
-      Memory.at(base + offset) = value;
+      Memory[base + offset] = value;
       break;
     }
     case WPLUS:
@@ -293,8 +370,7 @@ void WhileState::step(bool trace)
       int b = readDataOperand(instr, 2);
 
       int result = a + b;
-      if (trace)
-        std::cout << " writes " << result;
+      trace.event(WTRACE_WRITES, result);
 
       writeRegisterOperand(instr, 0, result);
       break;
@@ -307,8 +383,7 @@ void WhileState::step(bool trace)
       int b = readDataOperand(instr, 2);
 
       int result = a - b;
-      if (trace)
-        std::cout << " writes " << result;
+      trace.event(WTRACE_WRITES, result);
 
       writeRegisterOperand(instr, 0, result);
       break;
@@ -321,8 +396,7 @@ void WhileState::step(bool trace)
       int b = readDataOperand(instr, 2);
 
       int result = a * b;
-      if (trace)
-        std::cout << " writes " << result;
+      trace.event(WTRACE_WRITES, result);
 
       writeRegisterOperand(instr, 0, result);
       break;
@@ -335,8 +409,7 @@ void WhileState::step(bool trace)
       int b = readDataOperand(instr, 2);
 
       int result = a / b;
-      if (trace)
-        std::cout << " writes " << result;
+      trace.event(WTRACE_WRITES, result);
 
       writeRegisterOperand(instr, 0, result);
       break;
@@ -349,8 +422,7 @@ void WhileState::step(bool trace)
       int b = readDataOperand(instr, 2);
 
       int result = a == b;
-      if (trace)
-        std::cout << " writes " << result;
+      trace.event(WTRACE_WRITES, result);
 
       writeRegisterOperand(instr, 0, result);
       break;
@@ -363,8 +435,7 @@ void WhileState::step(bool trace)
       int b = readDataOperand(instr, 2);
 
       int result = a != b;
-      if (trace)
-        std::cout << " writes " << result;
+      trace.event(WTRACE_WRITES, result);
 
       writeRegisterOperand(instr, 0, result);
       break;
@@ -377,8 +448,7 @@ void WhileState::step(bool trace)
       int b = readDataOperand(instr, 2);
 
       int result = a < b;
-      if (trace)
-        std::cout << " writes " << result;
+      trace.event(WTRACE_WRITES, result);
 
       writeRegisterOperand(instr, 0, result);
       break;
@@ -391,8 +461,7 @@ void WhileState::step(bool trace)
       int b = readDataOperand(instr, 2);
 
       int result = a <= b;
-      if (trace)
-        std::cout << " writes " << result;
+      trace.event(WTRACE_WRITES, result);
 
       writeRegisterOperand(instr, 0, result);
       break;
@@ -404,11 +473,10 @@ void WhileState::step(bool trace)
       {
         if(readDataOperand(instr, 0) == 0)
         {
-          if (trace)
-            std::cout << " taken";
+          trace.event(WTRACE_TAKEN);
 
           ctx.Block = nextBB;
-          ctx.InstructionPointer = nextBB->Body.cbegin();
+          ctx.InstructionPointer = nextBB->Body.begin();
         }
       }
       else
@@ -424,7 +492,7 @@ void WhileState::step(bool trace)
       if (nextBB)
       {
         ctx.Block = nextBB;
-        ctx.InstructionPointer = nextBB->Body.cbegin();
+        ctx.InstructionPointer = nextBB->Body.begin();
       }
       else
       {
@@ -437,10 +505,10 @@ void WhileState::step(bool trace)
     {
       int retval = readDataOperand(instr, 0);
 
-      if (trace)
-        std::cout << " returns " << retval;
+      trace.event(WTRACE_RETURNS, retval);
+      trace.leave(*ctx.Function);
 
-      Context.pop_back();
+      popContext();
 
       if (Context.empty())
       {
@@ -458,10 +526,10 @@ void WhileState::step(bool trace)
           switch (op.Kind)
           {
             case WREGISTER:
-              assert(op.ValueOrIndex >= 0);
-              if (callctx.Registers.size() <= (unsigned int)op.ValueOrIndex)
-                callctx.Registers.resize(op.ValueOrIndex+1);
-              callctx.Registers[op.ValueOrIndex] = retval;
+              assert(op.ValueOrIndex >= 0 &&
+                     (unsigned int)op.ValueOrIndex <
+                     callctx.Function->NumRegisters);
+              Registers[callctx.RegisterBase + op.ValueOrIndex] = retval;
               break;
 
             case WIMMEDIATE:
@@ -483,11 +551,64 @@ void WhileState::step(bool trace)
     }
   }
 
+  trace.end();
+}
+
+void WhileState::step(bool trace)
+{
   if (trace)
-    std::cout << "\n";
+  {
+    WhileTextTrace t(std::cout);
+    step(t);
+  }
+  else
+  {
+    WhileNoTrace t;
+    step(t);
+  }
 }
 
-void WhileState::run(bool trace, unsigned int steps)
+void WhileState::reportMemoryFault(const WhileInstr &i, int addr)
+{
+  std::cerr << "runtime error: line " << i.Line << ":" << i.OffsetOnLine
+            << " invalid memory access at address " << addr
+            << " in function '" << i.Block->Function->Name
+            << "' (memory size " << Memory.size() << ").\n";
+
+  Done = true;
+  Error = true;
+}
+
+void WhileState::reportStackOverflow(
+    const std::vector<const WhileInstr *> &calls, const WhileFunction *callee)
+{
+  const WhileInstr &call = *calls.front();
+  std::cerr << "runtime error: line " << call.Line << ":" << call.OffsetOnLine
+            << " stack overflow calling '" << callee->Name
+            << "' (stack size " << Memory.size() - Program->DataSize
+            << " words), call chain:\n";
+
+  // only show the innermost and outermost calls of deep recursions.
+  const unsigned int shown = 10;
+  for(unsigned int d = 0; d < calls.size(); d++)
+  {
+    if (d == shown && calls.size() > 2 * shown)
+    {
+      std::cerr << "  ... " << calls.size() - 2 * shown << " more calls ...\n";
+      d = calls.size() - shown;
+    }
+
+    const WhileInstr &c = *calls[d];
+    std::cerr << "  #" << d << " " << c.Block->Function->Name << " at line "
+              << c.Line << ":" << c.OffsetOnLine << "\n";
+  }
+
+  Done = true;
+  Error = true;
+}
+
+template<typename T>
+void WhileState::run(T &trace, unsigned int steps)
 {
   while(steps != 0 && !Done)
   {
@@ -496,6 +617,29 @@ void WhileState::run(bool trace, unsigned int steps)
   }
 }
 
+void WhileState::run(bool trace, unsigned int steps)
+{
+  if (trace)
+  {
+    WhileTextTrace t(std::cout);
+    run(t, steps);
+  }
+  else
+  {
+    WhileNoTrace t;
+    run(t, steps);
+  }
+}
+
+template void WhileState::step(WhileNoTrace &);
+template void WhileState::step(WhileTextTrace &);
+template void WhileState::step(WhileBinaryTrace &);
+template void WhileState::step(WhileProfile &);
+template void WhileState::run(WhileNoTrace &, unsigned int);
+template void WhileState::run(WhileTextTrace &, unsigned int);
+template void WhileState::run(WhileBinaryTrace &, unsigned int);
+template void WhileState::run(WhileProfile &, unsigned int);
+
 std::ostream &WhileState::dump(std::ostream &s) const
 {
   unsigned int ident = 0;
@@ -512,13 +656,22 @@ std::ostream &WhileState::dump(std::ostream &s) const
       s << "??\n";
   }
 
-  unsigned int idx = 0;
-  for(int regval : Context.back().Registers)
+  if (Context.empty())
+    return s;
+
+  const WhileContext &ctx = Context.back();
+  for(unsigned int idx = 0; idx < ctx.Function->NumRegisters; idx++)
   {
     s << std::setw(2*ident++) << "|"
-      << "R" << std::left << std::setw(2) << idx++ << std::right << ": "
-      << regval << "\n";
+      << "R" << std::left << std::setw(2) << idx << std::right << ": "
+      << Registers[ctx.RegisterBase + idx] << "\n";
   }
 
   return s;
 }
+
+std::ostream &WhileState::dumpStats(std::ostream &s) const
+{
+  return s << "max. call depth: " << MaxCallDepth << "\n"
+           << "max. frame memory: " << MaxFrameMemory << " bytes\n";
+}
@@ -26,15 +26,37 @@
 #include "WhileCFG.h"
 #include "WhileColor.h"
 
+#include <climits>
 
+
+// The set of possible frame pointer values. The set {UnknownFramePointer}
+// stands for any value, it results from widening at the entries of recursive
+// functions, whose frame pointers are unbounded otherwise.
 typedef std::set<unsigned int> WhileFramePointerDomain;
 
+static const unsigned int UnknownFramePointer = UINT_MAX;
+
+static bool isUnknown(const WhileFramePointerDomain &value)
+{
+  return value.count(UnknownFramePointer) != 0;
+}
+
 struct WhileFramePointer
-  : public WhileInterproceduralDataFlowAnalysis<WhileFramePointerDomain>
+  : public WhileByValueAnalysis<
+             WhileInterproceduralDataFlowAnalysis<WhileFramePointerDomain>>
 {
+  WhileFramePointer()
+  {
+    Widening = true;
+    NarrowingSteps = 0;
+  }
+
   std::ostream &dump_entry(std::ostream &s,
                            const WhileFramePointerDomain &value) override
   {
+    if (isUnknown(value))
+      return s << "[⊤]";
+
     s << "[";
     bool first = true;
     for(unsigned int fp : value)
@@ -67,6 +89,20 @@ struct WhileFramePointer
     return dump_first(s, value);
   }
 
+  // The frame pointer does not change within a function, only recursion needs
+  // widening.
+  bool isWideningPoint(const WhileBlock *bb) override
+  {
+    return bb->isEntry() && Recursive[bb->Function->Index];
+  }
+
+  void widen(WhileFramePointerDomain &value,
+             const WhileFramePointerDomain &previous) override
+  {
+    if (value != previous)
+      value = {UnknownFramePointer};
+  }
+
   virtual WhileFramePointerDomain initialize(const WhileFunction *f) override
   {
     WhileFramePointerDomain result;
@@ -100,6 +136,9 @@ struct WhileFramePointer
   WhileFramePointerDomain transfer(const WhileInstr &instr, const WhileFramePointerDomain input) override
   {
     const auto &ops = instr.Ops;
+    if (isUnknown(input))
+      return input;
+
     switch(instr.Opc)
     {
       case WRETURN:
@@ -155,7 +194,12 @@ struct WhileFramePointer
   {
     WhileFramePointerDomain result;
     for(const WhileFramePointerDomain &v : inputs)
+    {
+      if (isUnknown(v))
+        return v;
+
       result.insert(v.begin(), v.end());
+    }
 
     return result;
   }
@@ -164,11 +208,12 @@ struct WhileFramePointer
 
 struct WhileInterproceduralFramePointerAnalysis : public WhileAnalysis
 {
-  void analyze(const WhileProgram &p) override
+  void analyze(const WhileProgram &p, std::ostream &s) override
   {
     WhileFramePointer WIFPA;
     WIFPA.analyze(p);
-    WIFPA.dump(std::cout, p);
+    Stats = WIFPA.Stats;
+    WIFPA.dump(s, p);
   };
 
   WhileInterproceduralFramePointerAnalysis() : WhileAnalysis("WIFPA",
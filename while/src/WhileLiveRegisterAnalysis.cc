@@ -0,0 +1,120 @@
+// This file is part of While, an educational programming language and program
+// analysis framework.
+//
+//   Copyright 2023 Florian Brandner
+//
+// While is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// While is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+// A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// While. If not, see <https://www.gnu.org/licenses/>.
+//
+// Contact: florian.brandner@telecom-paris.fr
+//
+
+
+// This file implements a live register analysis, i.e., determines the symbolic
+// registers whose value may be read later on, for each program point.
+
+#include "WhileAnalysis.h"
+#include "WhileLang.h"
+#include "WhileCFG.h"
+#include "WhileColor.h"
+
+struct WhileLiveRegisters : public WhileGenKillAnalysis<WBACKWARD>
+{
+  std::ostream &dump_first(std::ostream &s,
+                           const WhileBitVector &value) override
+  {
+    s << "    " << FGREEN;
+    return value.dump(s, "R") << CRESET << "\n";
+  }
+
+  std::ostream &dump_pre(std::ostream &s,
+                         const WhileBitVector &value) override
+  {
+    return s;
+  }
+
+  std::ostream &dump_post(std::ostream &s,
+                          const WhileBitVector &value) override
+  {
+    return dump_first(s, value);
+  }
+
+  unsigned int width(const WhileFunction &f) override
+  {
+    return f.NumRegisters;
+  }
+
+  void genKill(const WhileInstr &instr, WhileBitVector &gen,
+               WhileBitVector &kill) override
+  {
+    // index of the operand written by the instruction, if any.
+    unsigned int def = instr.Ops.size();
+    switch(instr.Opc)
+    {
+      case WCALL:
+        // Ops: Fun Opd = Arg1, Arg2, ... ArgN
+        def = 1;
+        break;
+
+      case WLOAD:
+      case WPLUS:
+      case WMINUS:
+      case WMULT:
+      case WDIV:
+      case WEQUAL:
+      case WUNEQUAL:
+      case WLESS:
+      case WLESSEQUAL:
+        // Ops: OpD = ...
+        def = 0;
+        break;
+
+      case WSTORE:
+      case WBRANCHZ:
+      case WBRANCH:
+      case WRETURN:
+        // do not write symbolic registers
+        break;
+    };
+
+    for(unsigned int idx = 0; idx < instr.Ops.size(); idx++)
+    {
+      const WhileOperand &op = instr.Ops[idx];
+      if (op.Kind != WREGISTER)
+        continue;
+
+      assert(op.ValueOrIndex >= 0);
+      if (idx == def)
+        kill.set(op.ValueOrIndex);
+      else
+        gen.set(op.ValueOrIndex);
+    }
+  }
+};
+
+
+struct WhileLiveRegisterAnalysis : public WhileAnalysis
+{
+  void analyze(const WhileProgram &p, std::ostream &s) override
+  {
+    WhileLiveRegisters WLRA;
+    analyzeParallel(WLRA, p, Threads);
+    Stats = WLRA.Stats;
+    WLRA.dump(s, p);
+  };
+
+  WhileLiveRegisterAnalysis() : WhileAnalysis("WLRA", "Live Register Analysis")
+  {
+  }
+};
+
+WhileLiveRegisterAnalysis WLRA;
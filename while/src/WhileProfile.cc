@@ -0,0 +1,227 @@
+// This file is part of While, an educational programming language and program
+// analysis framework.
+//
+//   Copyright 2023 Florian Brandner
+//
+// While is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// While is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+// A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// While. If not, see <https://www.gnu.org/licenses/>.
+//
+// Contact: florian.brandner@telecom-paris.fr
+//
+
+// This file implements the execution profiler of the interpreter and its
+// reports.
+
+#include "WhileProfile.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <tuple>
+
+extern const char *WhileOpcodes[];
+
+WhileFunctionProfile::WhileFunctionProfile(const WhileFunction &f)
+  : Function(&f), Blocks(f.BlocksByIndex.size())
+{
+  for(const WhileBlock *bb : f.BlocksByIndex)
+  {
+    BlockStart.emplace_back(Source.size());
+    for(const WhileInstr &i : bb->Body)
+      Source.emplace_back(&i);
+  }
+
+  Instrs.resize(Source.size());
+}
+
+uint64_t WhileFunctionProfile::self() const
+{
+  uint64_t steps = 0;
+  for(uint64_t c : Instrs)
+    steps += c;
+  return steps;
+}
+
+WhileProfile::WhileProfile(const WhileProgram &p)
+{
+  for(const WhileFunction *f : p.FunctionsByIndex)
+    Functions.emplace_back(*f);
+
+  // the interpreter starts in main without executing a call.
+  const auto main = p.Functions.find("main");
+  if (main != p.Functions.end())
+    enter(main->second);
+}
+
+void WhileProfile::finish()
+{
+  for(WhileFunctionProfile &f : Functions)
+  {
+    if (f.Active != 0)
+    {
+      f.Inclusive += Steps - f.EnterStep;
+      f.Active = 0;
+    }
+  }
+}
+
+static std::ostream &percent(std::ostream &s, uint64_t count, uint64_t total)
+{
+  double p = total ? 100.0 * count / total : 0.0;
+  return s << std::fixed << std::setprecision(1) << std::setw(5) << p << "%";
+}
+
+std::ostream &WhileProfile::dump(std::ostream &s, unsigned int top) const
+{
+  s << "steps: " << Steps << "\n\n";
+
+  // functions, sorted by inclusive steps.
+  std::vector<const WhileFunctionProfile *> funs;
+  for(const WhileFunctionProfile &f : Functions)
+    funs.emplace_back(&f);
+  std::stable_sort(funs.begin(), funs.end(),
+                   [](const WhileFunctionProfile *a,
+                      const WhileFunctionProfile *b) {
+                     return a->Inclusive > b->Inclusive;
+                   });
+
+  s << std::left << std::setw(20) << "function" << std::right
+    << std::setw(12) << "calls" << std::setw(22) << "self steps"
+    << std::setw(22) << "inclusive steps" << "\n";
+  for(const WhileFunctionProfile *f : funs)
+  {
+    s << std::left << std::setw(20) << f->Function->Name << std::right
+      << std::setw(12) << f->Calls << std::setw(14) << f->self() << " (";
+    percent(s, f->self(), Steps) << ")" << std::setw(14) << f->Inclusive
+                                  << " (";
+    percent(s, f->Inclusive, Steps) << ")\n";
+  }
+
+  // source lines, the counts of all instructions of a line are summed up.
+  typedef std::tuple<uint64_t, const WhileFunction *, unsigned int> line_t;
+  std::vector<line_t> lines;
+  for(const WhileFunctionProfile &f : Functions)
+  {
+    std::vector<std::pair<unsigned int, uint64_t>> counts;
+    for(unsigned int idx = 0; idx < f.Source.size(); idx++)
+      counts.emplace_back(f.Source[idx]->Line, f.Instrs[idx]);
+    std::sort(counts.begin(), counts.end());
+
+    for(unsigned int idx = 0; idx < counts.size(); idx++)
+    {
+      if (idx == 0 || counts[idx].first != counts[idx - 1].first)
+        lines.emplace_back(0, f.Function, counts[idx].first);
+      std::get<0>(lines.back()) += counts[idx].second;
+    }
+  }
+  std::stable_sort(lines.begin(), lines.end(),
+                   [](const line_t &a, const line_t &b) {
+                     return std::get<0>(a) > std::get<0>(b);
+                   });
+
+  s << "\nhot source lines:\n" << std::setw(14) << "steps" << std::setw(8)
+    << "" << std::setw(7) << "line" << "  function\n";
+  for(unsigned int idx = 0; idx < lines.size() && idx < top; idx++)
+  {
+    const auto &[count, fun, line] = lines[idx];
+    if (count == 0)
+      break;
+
+    s << std::setw(14) << count << " (";
+    percent(s, count, Steps) << ")" << std::setw(7) << line << "  "
+                             << fun->Name << "\n";
+  }
+
+  // blocks, sorted by the number of executions.
+  typedef std::pair<uint64_t, const WhileBlock *> block_t;
+  std::vector<block_t> blocks;
+  for(const WhileFunctionProfile &f : Functions)
+  {
+    for(unsigned int bb = 0; bb < f.Blocks.size(); bb++)
+      blocks.emplace_back(f.Blocks[bb], f.Function->BlocksByIndex[bb]);
+  }
+  std::stable_sort(blocks.begin(), blocks.end(),
+                   [](const block_t &a, const block_t &b) {
+                     return a.first > b.first;
+                   });
+
+  s << "\nhot blocks:\n" << std::setw(14) << "executions" << "  block\n";
+  for(unsigned int idx = 0; idx < blocks.size() && idx < top; idx++)
+  {
+    const auto &[count, bb] = blocks[idx];
+    if (count == 0)
+      break;
+
+    s << std::setw(14) << count << "  " << bb->Function->Name << "::BB"
+      << bb->Index;
+    if (!bb->Body.empty())
+      s << " (line " << bb->Body.front().Line << ")";
+    s << "\n";
+  }
+
+  return s;
+}
+
+std::ostream &WhileProfile::dumpJSON(std::ostream &s) const
+{
+  s << "{\n  \"steps\": " << Steps << ",\n  \"functions\": [";
+  for(unsigned int fi = 0; fi < Functions.size(); fi++)
+  {
+    const WhileFunctionProfile &f = Functions[fi];
+    s << (fi ? "," : "") << "\n    {\"name\": \"" << f.Function->Name
+      << "\", \"index\": " << f.Function->Index
+      << ", \"calls\": " << f.Calls
+      << ", \"self\": " << f.self()
+      << ", \"inclusive\": " << f.Inclusive << ",\n     \"blocks\": [";
+
+    for(unsigned int bb = 0; bb < f.Blocks.size(); bb++)
+      s << (bb ? ", " : "") << f.Blocks[bb];
+
+    s << "],\n     \"instructions\": [";
+    for(unsigned int idx = 0; idx < f.Source.size(); idx++)
+    {
+      const WhileInstr &i = *f.Source[idx];
+      s << (idx ? "," : "") << "\n       {\"block\": " << i.Block->Index
+        << ", \"index\": " << i.Index
+        << ", \"line\": " << i.Line
+        << ", \"column\": " << i.OffsetOnLine
+        << ", \"opcode\": \"" << WhileOpcodes[i.Opc]
+        << "\", \"count\": " << f.Instrs[idx] << "}";
+    }
+    s << "]}";
+  }
+  return s << "\n  ]\n}\n";
+}
+
+std::ostream &WhileProfile::dumpCSV(std::ostream &s) const
+{
+  s << "kind,function,block,instruction,line,column,opcode,count,calls,"
+       "inclusive\n";
+  for(const WhileFunctionProfile &f : Functions)
+  {
+    const std::string &name = f.Function->Name;
+    s << "function," << name << ",,,,,," << f.self() << "," << f.Calls
+      << "," << f.Inclusive << "\n";
+
+    for(unsigned int bb = 0; bb < f.Blocks.size(); bb++)
+      s << "block," << name << "," << bb << ",,,,," << f.Blocks[bb]
+        << ",,\n";
+
+    for(unsigned int idx = 0; idx < f.Source.size(); idx++)
+    {
+      const WhileInstr &i = *f.Source[idx];
+      s << "instruction," << name << "," << i.Block->Index << ","
+        << i.Index << "," << i.Line << "," << i.OffsetOnLine << ","
+        << WhileOpcodes[i.Opc] << "," << f.Instrs[idx] << ",,\n";
+    }
+  }
+  return s;
+}
@@ -25,7 +25,9 @@
 #include <iostream>
 #include <string>
 #include <cstring>
+#include <cstdlib>
 #include <list>
+#include <memory>
 
 #include "antlr4-runtime.h"
 #include "WhileParser.h"
@@ -34,7 +36,13 @@
 
 #include "WhileLang.h"
 #include "WhileCFG.h"
+#include "WhileBinary.h"
 #include "WhileInterpreter.h"
+#include "WhileBytecode.h"
+#include "WhileTrace.h"
+#include "WhileProfile.h"
+
+#include <fstream>
 
 const char *WhileTypes[4] = {"int", "int *", "int[]", "unknown"};
 
@@ -49,10 +57,46 @@ static void version()
 
 static void usage(const char *prog)
 {
-  std::cerr << "Usage: " << prog << "[-t] [-d] <input.whl>\n\n"
+  std::cerr << "Usage: " << prog << "[-t] [-d] [-s] [-m <mode>] [--unchecked] "
+            << "[--stack-size <words>] [--trace-file <file>] "
+            << "[--print-trace <file>] [-p] [--profile-format <format>] "
+            << "[--profile-file <file>] <input.whl>\n\n"
             << "\t-t\tTrace instructions while interpreting.\n"
+            << "\t--trace-file\n"
+            << "\t\tWrite a binary trace of the execution to a file.\n"
+            << "\t--print-trace\n"
+            << "\t\tPrint a binary trace of the input program, as written\n"
+            << "\t\tby --trace-file, instead of executing it.\n"
             << "\t-d\tDump control-flow graph.\n"
-            << "\t-v\tPrint version and license information.\n\n";
+            << "\t-s\tPrint call stack statistics after execution.\n"
+            << "\t-p\tProfile the execution and print a report of the hot\n"
+            << "\t\tfunctions, source lines, and blocks to stderr.\n"
+            << "\t--profile-format\n"
+            << "\t\tFormat of the profile, one of 'text' (default), 'json',\n"
+            << "\t\tor 'csv' (implies -p).\n"
+            << "\t--profile-file\n"
+            << "\t\tWrite the profile to a file instead of stderr\n"
+            << "\t\t(implies -p).\n"
+            << "\t-m\tSelect the execution mode:\n"
+            << "\t\tcfg       walk the control-flow graph (default),\n"
+            << "\t\tbytecode  execute pre-decoded flat bytecode,\n"
+            << "\t\tthreaded  execute bytecode using computed-goto dispatch\n"
+            << "\t\t          (same as bytecode if not supported by the\n"
+            << "\t\t          compiler).\n"
+            << "\t--unchecked\n"
+            << "\t\tDo not check memory accesses. By default, invalid\n"
+            << "\t\taccesses are reported as runtime errors.\n"
+            << "\t--stack-size\n"
+            << "\t\tSet the size of the stack in words (default "
+            << WhileState::DefaultStackSize << "). Stack overflows are\n"
+            << "\t\treported as runtime errors.\n"
+            << "\t-v\tPrint version and license information.\n\n"
+            << "The input is either While source code or a program compiled\n"
+            << "by while-compile.\n\n"
+            << "The exit code is the value returned by main. Runtime errors\n"
+            << "print a message starting with 'runtime error:' to stderr and\n"
+            << "exit with code 4, which main may return as well, check for\n"
+            << "the message to tell them apart.\n\n";
 
   version();
   exit(3);
@@ -65,6 +109,16 @@ int main(int argc, char *argv[])
 
   bool dump = false;
   bool trace = false;
+  bool stats = false;
+  bool bytecode = false;
+  bool threaded = false;
+  bool unchecked = false;
+  unsigned int stacksize = WhileState::DefaultStackSize;
+  const char *tracefile = nullptr;
+  const char *printtrace = nullptr;
+  bool profile = false;
+  std::string profileformat = "text";
+  const char *profilefile = nullptr;
   std::string filename = argv[argc-1];
 
   for(int i = 1; i < argc-1; i++)
@@ -73,32 +127,169 @@ int main(int argc, char *argv[])
       trace = true;
     else if (!std::strcmp(argv[i], "-d"))
       dump = true;
+    else if (!std::strcmp(argv[i], "-s"))
+      stats = true;
+    else if (!std::strcmp(argv[i], "-p"))
+      profile = true;
+    else if (!std::strcmp(argv[i], "--profile-format") && i + 1 < argc - 1)
+    {
+      profile = true;
+      profileformat = argv[++i];
+      if (profileformat != "text" && profileformat != "json" &&
+          profileformat != "csv")
+        usage(argv[0]);
+    }
+    else if (!std::strcmp(argv[i], "--profile-file") && i + 1 < argc - 1)
+    {
+      profile = true;
+      profilefile = argv[++i];
+    }
+    else if (!std::strcmp(argv[i], "-m") && i + 1 < argc - 1)
+    {
+      i++;
+      if (!std::strcmp(argv[i], "cfg"))
+        bytecode = threaded = false;
+      else if (!std::strcmp(argv[i], "bytecode"))
+      {
+        bytecode = true;
+        threaded = false;
+      }
+      else if (!std::strcmp(argv[i], "threaded"))
+        bytecode = threaded = true;
+      else
+        usage(argv[0]);
+    }
+    else if (!std::strcmp(argv[i], "--unchecked"))
+      unchecked = true;
+    else if (!std::strcmp(argv[i], "--trace-file") && i + 1 < argc - 1)
+      tracefile = argv[++i];
+    else if (!std::strcmp(argv[i], "--print-trace") && i + 1 < argc - 1)
+      printtrace = argv[++i];
+    else if (!std::strcmp(argv[i], "--stack-size") && i + 1 < argc - 1)
+    {
+      char *end;
+      unsigned long words = std::strtoul(argv[++i], &end, 10);
+      if (*end != '\0' || words == 0 ||
+          words > WhileState::MaxStackSize)
+        usage(argv[0]);
+
+      stacksize = words;
+    }
     else if (!std::strcmp(argv[i], "-v"))
       version();
     else
       usage(argv[0]);
   }
 
-  antlr4::ANTLRFileStream input(filename);
-  WhileLexer lexer(&input);
-  antlr4::CommonTokenStream tokens(&lexer);
-  WhileParser parser(&tokens);
+  // Programs compiled by while-compile are loaded directly, skipping the
+  // parser and the code generator.
+  std::unique_ptr<WhileProgram> program;
+  if (isBinaryProgram(filename))
+  {
+    program = readBinaryProgram(filename);
+    if (!program)
+      return 1;
+  }
+  else
+  {
+    antlr4::ANTLRFileStream input(filename);
+    WhileLexer lexer(&input);
+    antlr4::CommonTokenStream tokens(&lexer);
+    WhileParser parser(&tokens);
 
-  antlr4::tree::ParseTree *tree = parser.program();
+    antlr4::tree::ParseTree *tree = parser.program();
 
-  if (parser.getNumberOfSyntaxErrors() != 0)
-    return 1;
+    if (parser.getNumberOfSyntaxErrors() != 0)
+      return 1;
 
-  if (parser.Error)
-    return 2;
+    if (parser.Error)
+      return 2;
 
-  WhileProgram *program = generateCode(tree);
+    program = generateCode(tree);
+  }
 
   if (dump)
     program->dump(std::cout);
 
-  WhileState s(program);
-  s.run(trace);
+  if (printtrace)
+  {
+    if (!dumpBinaryTrace(std::cout, printtrace, *program))
+    {
+      std::cerr << "Invalid trace file '" << printtrace << "'.\n";
+      return 3;
+    }
+    return 0;
+  }
+
+  WhileState s(program.get(), stacksize);
+  s.Checked = !unchecked;
+  if (bytecode)
+  {
+    if (trace || tracefile || profile)
+    {
+      std::cerr << "Tracing and profiling are only supported in 'cfg' "
+                   "mode.\n";
+      return 3;
+    }
+
+    WhileBytecode code(*program);
+    if (dump)
+      code.dump(std::cout);
+
+    if (threaded)
+      code.runThreaded(s);
+    else
+      code.run(s);
+  }
+  else if (profile)
+  {
+    if (trace || tracefile)
+    {
+      std::cerr << "Tracing and profiling cannot be combined.\n";
+      return 3;
+    }
+
+    WhileProfile p(*program);
+    s.run(p);
+    p.finish();
+
+    std::ofstream file;
+    if (profilefile)
+    {
+      file.open(profilefile);
+      if (!file)
+      {
+        std::cerr << "Cannot write profile file '" << profilefile << "'.\n";
+        return 3;
+      }
+    }
+
+    std::ostream &out = profilefile ? file : std::cerr;
+    if (profileformat == "json")
+      p.dumpJSON(out);
+    else if (profileformat == "csv")
+      p.dumpCSV(out);
+    else
+      p.dump(out);
+  }
+  else if (tracefile)
+  {
+    WhileBinaryTrace t(tracefile);
+    if (!t.good())
+    {
+      std::cerr << "Cannot write trace file '" << tracefile << "'.\n";
+      return 3;
+    }
+    s.run(t);
+  }
+  else
+    s.run(trace);
+
+  if (stats)
+    s.dumpStats(std::cerr);
+
+  if (s.Error)
+    return 4;
 
   return s.ExitState;
 }
@@ -0,0 +1,135 @@
+// This file is part of While, an educational programming language and program
+// analysis framework.
+//
+//   Copyright 2023 Florian Brandner
+//
+// While is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// While is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+// A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// While. If not, see <https://www.gnu.org/licenses/>.
+//
+// Contact: florian.brandner@telecom-paris.fr
+//
+
+// This file implements the text and binary trace policies of the interpreter,
+// as well as a printer for binary traces.
+
+#include "WhileTrace.h"
+
+#include <algorithm>
+
+static const char WhileTraceMagic[4] = {'W', 'T', 'R', 'C'};
+
+static std::ostream &dumpStep(std::ostream &s, const WhileFunction &f,
+                              const WhileBlock &bb, const WhileInstr &i,
+                              unsigned int fp)
+{
+  s << f.Name << "(" << f.Index << ")::" << bb.Index << "::" << i.Index
+    << ": ";
+  i.dump(s);
+
+  return s << " FP=" << fp << " SP=" << fp + f.FrameSize;
+}
+
+static std::ostream &dumpEvent(std::ostream &s, WhileTraceEvent e, int value)
+{
+  switch(e)
+  {
+    case WTRACE_NONE:
+      return s;
+    case WTRACE_WRITES:
+      return s << " writes " << value;
+    case WTRACE_TAKEN:
+      return s << " taken";
+    case WTRACE_RETURNS:
+      return s << " returns " << value;
+  }
+  abort();
+}
+
+void WhileTextTrace::begin(const WhileContext &ctx, const WhileInstr &i)
+{
+  dumpStep(Out, *ctx.Function, *ctx.Block, i, ctx.FramePointer);
+}
+
+void WhileTextTrace::event(WhileTraceEvent e, int value)
+{
+  dumpEvent(Out, e, value);
+}
+
+void WhileTextTrace::end()
+{
+  Out << "\n";
+}
+
+WhileBinaryTrace::WhileBinaryTrace(const std::string &filename)
+  : Out(filename, std::ios::binary)
+{
+  Buffer.reserve(BufferSize);
+
+  uint32_t header[2] = {Version, sizeof(WhileTraceRecord)};
+  Out.write(WhileTraceMagic, sizeof(WhileTraceMagic));
+  Out.write(reinterpret_cast<const char*>(header), sizeof(header));
+}
+
+WhileBinaryTrace::~WhileBinaryTrace()
+{
+  flush();
+}
+
+void WhileBinaryTrace::flush()
+{
+  Out.write(reinterpret_cast<const char*>(Buffer.data()),
+            Buffer.size() * sizeof(WhileTraceRecord));
+  Buffer.clear();
+}
+
+bool dumpBinaryTrace(std::ostream &s, const std::string &filename,
+                     const WhileProgram &p)
+{
+  std::ifstream in(filename, std::ios::binary);
+
+  char magic[sizeof(WhileTraceMagic)];
+  uint32_t header[2];
+  in.read(magic, sizeof(magic));
+  in.read(reinterpret_cast<char*>(header), sizeof(header));
+  if (!in || !std::equal(magic, magic + sizeof(magic), WhileTraceMagic) ||
+      header[0] != WhileBinaryTrace::Version ||
+      header[1] != sizeof(WhileTraceRecord))
+    return false;
+
+  std::vector<WhileTraceRecord> buffer(WhileBinaryTrace::BufferSize);
+  while(in)
+  {
+    in.read(reinterpret_cast<char*>(buffer.data()),
+            buffer.size() * sizeof(WhileTraceRecord));
+    std::size_t n = in.gcount() / sizeof(WhileTraceRecord);
+
+    for(std::size_t k = 0; k < n; k++)
+    {
+      const WhileTraceRecord &r = buffer[k];
+      if (r.Function >= p.FunctionsByIndex.size())
+        return false;
+
+      const WhileFunction &f = *p.FunctionsByIndex[r.Function];
+      if (r.Block >= f.BlocksByIndex.size())
+        return false;
+
+      const WhileBlock &block = *f.BlocksByIndex[r.Block];
+      if (r.instr() >= block.Body.size())
+        return false;
+
+      dumpStep(s, f, block, block.Body[r.instr()], r.FramePointer);
+      dumpEvent(s, r.event(), r.Value) << "\n";
+    }
+  }
+
+  return true;
+}
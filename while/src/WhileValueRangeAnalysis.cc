@@ -26,6 +26,8 @@
 #include "WhileCFG.h"
 #include "WhileColor.h"
 
+#include <climits>
+
 
 enum WhileConstantKind
 {
@@ -59,41 +61,54 @@ struct WhileRangeValue
 
   /// operations
 
+  // Bounds at INT_MIN and INT_MAX stand for -∞ and +∞, results saturate.
+  static int saturate(long long v)
+  {
+    return std::clamp<long long>(v, INT_MIN, INT_MAX);
+  }
+
+  bool containsZero() const
+  {
+    return lowerValue <= 0 && 0 <= upperValue;
+  }
+
    // Overload + operator
   WhileRangeValue operator+(const WhileRangeValue& other) const
   {
-    return WhileRangeValue{Kind, lowerValue + other.lowerValue, upperValue + other.upperValue};
+    int min = lowerValue == INT_MIN || other.lowerValue == INT_MIN ? INT_MIN :
+              saturate((long long)lowerValue + other.lowerValue);
+    int max = upperValue == INT_MAX || other.upperValue == INT_MAX ? INT_MAX :
+              saturate((long long)upperValue + other.upperValue);
+    return WhileRangeValue{Kind, min, max};
   }
 
   // Overload - operator
   WhileRangeValue operator-(const WhileRangeValue& other) const
   {
-    return WhileRangeValue{Kind, lowerValue - other.upperValue, upperValue - other.lowerValue};
+    int min = lowerValue == INT_MIN || other.upperValue == INT_MAX ? INT_MIN :
+              saturate((long long)lowerValue - other.upperValue);
+    int max = upperValue == INT_MAX || other.lowerValue == INT_MIN ? INT_MAX :
+              saturate((long long)upperValue - other.lowerValue);
+    return WhileRangeValue{Kind, min, max};
   }
 
   // Overload * operator
   WhileRangeValue operator*(const WhileRangeValue& other) const
   {
-    int min = std::min({lowerValue * other.lowerValue, lowerValue * other.upperValue,
-                         upperValue * other.lowerValue, upperValue * other.upperValue});
-    int max = std::max({lowerValue * other.lowerValue, lowerValue * other.upperValue,
-                         upperValue * other.lowerValue, upperValue * other.upperValue});
+    long long a = lowerValue, b = upperValue;
+    long long c = other.lowerValue, d = other.upperValue;
+    int min = saturate(std::min({a * c, a * d, b * c, b * d}));
+    int max = saturate(std::max({a * c, a * d, b * c, b * d}));
     return WhileRangeValue{Kind, min, max};
   }
 
-  // Overload / operator
+  // Overload / operator, the divisor must not contain 0.
   WhileRangeValue operator/(const WhileRangeValue& other) const
   {
-    // Handle division by zero
-    if (other.lowerValue == 0 && other.upperValue == 0)
-    {
-      throw std::runtime_error("Division by zero");
-    }
-
-    int min = std::min({lowerValue / other.lowerValue, lowerValue / other.upperValue,
-                         upperValue / other.lowerValue, upperValue / other.upperValue});
-    int max = std::max({lowerValue / other.lowerValue, lowerValue / other.upperValue,
-                         upperValue / other.lowerValue, upperValue / other.upperValue});
+    long long a = lowerValue, b = upperValue;
+    long long c = other.lowerValue, d = other.upperValue;
+    int min = saturate(std::min({a / c, a / d, b / c, b / d}));
+    int max = saturate(std::max({a / c, a / d, b / c, b / d}));
     return WhileRangeValue{Kind, min, max};
   }
 
@@ -122,7 +137,7 @@ bool operator==(const WhileRangeValue &a, const WhileRangeValue &b)
   return (a.Kind == b.Kind && a.upperValue == b.upperValue && a.lowerValue == b.lowerValue);
 }
 
-typedef std::map<int, WhileRangeValue> WhileConstantDomain;
+typedef WhileRegisterMap<WhileRangeValue> WhileConstantDomain;
 
 std::ostream &operator<<(std::ostream &s, const WhileRangeValue &v)
 {
@@ -133,7 +148,17 @@ std::ostream &operator<<(std::ostream &s, const WhileRangeValue &v)
     case BOTTOM:
       return s << FRED << "⊥" << CRESET;
     case CONSTANT:
-      return s << FGREEN << "[" << v.lowerValue << ":" << v.upperValue << "]" << CRESET;
+      s << FGREEN << "[";
+      if (v.lowerValue == INT_MIN)
+        s << "-∞";
+      else
+        s << v.lowerValue;
+      s << ":";
+      if (v.upperValue == INT_MAX)
+        s << "+∞";
+      else
+        s << v.upperValue;
+      return s << "]" << CRESET;
   };
   abort();
 }
@@ -141,13 +166,25 @@ std::ostream &operator<<(std::ostream &s, const WhileRangeValue &v)
 
 struct WhileConstant : public WhileDataFlowAnalysis<WhileConstantDomain>
 {
+  // Bounds that widening extrapolates to, before giving up with ±∞.
+  std::set<int> Thresholds;
+
+  WhileConstant()
+  {
+    Widening = true;
+  }
+
   std::ostream &dump_first(std::ostream &s,
                            const WhileConstantDomain &value) override
   {
     s << "    [";
     bool first = true;
-    for(const auto&[idx, c] : value)
+    for(unsigned int idx = 0; idx < value.size(); idx++)
     {
+      if (!value.contains(idx))
+        continue;
+
+      const WhileRangeValue &c = value[idx];
       if (!first)
         s << ", ";
 
@@ -201,11 +238,10 @@ struct WhileConstant : public WhileDataFlowAnalysis<WhileConstantDomain>
       case WREGISTER:
       {
         assert(op.ValueOrIndex >= 0);
-        auto value = input.find(op.ValueOrIndex);
-        if (value == input.end())
+        if (!input.contains(op.ValueOrIndex))
           return BOTTOM; // register undefined
         else
-          return value->second;
+          return input[op.ValueOrIndex];
       }
       case WIMMEDIATE:
         return op.ValueOrIndex;
@@ -221,9 +257,9 @@ struct WhileConstant : public WhileDataFlowAnalysis<WhileConstantDomain>
     abort();
   }
 
-  WhileConstantDomain transfer(const WhileInstr &instr, const WhileConstantDomain input) override
+  void transferInPlace(const WhileInstr &instr,
+                       WhileConstantDomain &value) override
   {
-    WhileConstantDomain result = input;
     const auto &ops = instr.Ops;
     switch(instr.Opc)
     {
@@ -238,7 +274,7 @@ struct WhileConstant : public WhileDataFlowAnalysis<WhileConstantDomain>
       {
         // Ops: Fun Opd = Arg1, Arg2, ... ArgN
         assert(ops.size() > 2);
-        updateRegisterOperand(instr, 1, result, BOTTOM);
+        updateRegisterOperand(instr, 1, value, BOTTOM);
         break;
       }
 
@@ -246,7 +282,7 @@ struct WhileConstant : public WhileDataFlowAnalysis<WhileConstantDomain>
       {
         // Ops: OpD = [BaseAddress + Offset]
         assert(ops.size() ==  3);
-        updateRegisterOperand(instr, 0, result, BOTTOM);
+        updateRegisterOperand(instr, 0, value, BOTTOM);
         break;
       }
 
@@ -254,109 +290,157 @@ struct WhileConstant : public WhileDataFlowAnalysis<WhileConstantDomain>
       {
         // Ops: OpD = OpA + OpB
         assert(ops.size() ==  3);
-        WhileRangeValue a = readDataOperand(instr, 1, input);
-        WhileRangeValue b = readDataOperand(instr, 2, input);
+        WhileRangeValue a = readDataOperand(instr, 1, value);
+        WhileRangeValue b = readDataOperand(instr, 2, value);
 
         if (a.Kind == CONSTANT && b.Kind == CONSTANT)
-          updateRegisterOperand(instr, 0, result, a + b);
+          updateRegisterOperand(instr, 0, value, a + b);
         else
-          updateRegisterOperand(instr, 0, result, BOTTOM);
+          updateRegisterOperand(instr, 0, value, BOTTOM);
         break;
       }
       case WMINUS:
       {
         // Ops: OpD = OpA - OpB
         assert(ops.size() ==  3);
-        WhileRangeValue a = readDataOperand(instr, 1, input);
-        WhileRangeValue b = readDataOperand(instr, 2, input);
+        WhileRangeValue a = readDataOperand(instr, 1, value);
+        WhileRangeValue b = readDataOperand(instr, 2, value);
 
         if (a.Kind == CONSTANT && b.Kind == CONSTANT)
-          updateRegisterOperand(instr, 0, result, a - b);
+          updateRegisterOperand(instr, 0, value, a - b);
         else
-          updateRegisterOperand(instr, 0, result, BOTTOM);
+          updateRegisterOperand(instr, 0, value, BOTTOM);
         break;
       }
       case WMULT:
       {
         // Ops: OpD = OpA * OpB
         assert(ops.size() ==  3);
-        WhileRangeValue a = readDataOperand(instr, 1, input);
-        WhileRangeValue b = readDataOperand(instr, 2, input);
+        WhileRangeValue a = readDataOperand(instr, 1, value);
+        WhileRangeValue b = readDataOperand(instr, 2, value);
 
         if (a.Kind == CONSTANT && b.Kind == CONSTANT)
-          updateRegisterOperand(instr, 0, result, a * b);
+          updateRegisterOperand(instr, 0, value, a * b);
         else
-          updateRegisterOperand(instr, 0, result, BOTTOM);
+          updateRegisterOperand(instr, 0, value, BOTTOM);
         break;
       }
       case WDIV:
       {
         // Ops: OpD = OpA / OpB
         assert(ops.size() ==  3);
-        WhileRangeValue a = readDataOperand(instr, 1, input);
-        WhileRangeValue b = readDataOperand(instr, 2, input);
+        WhileRangeValue a = readDataOperand(instr, 1, value);
+        WhileRangeValue b = readDataOperand(instr, 2, value);
 
-        if (a.Kind == CONSTANT && b.Kind == CONSTANT)
-          updateRegisterOperand(instr, 0, result, a / b);
+        if (a.Kind == CONSTANT && b.Kind == CONSTANT && !b.containsZero())
+          updateRegisterOperand(instr, 0, value, a / b);
         else
-          updateRegisterOperand(instr, 0, result, BOTTOM);
+          updateRegisterOperand(instr, 0, value, BOTTOM);
         break;
       }
       case WEQUAL:
       {
         // Ops: OpD = OpA == OpB
         assert(ops.size() ==  3);
-        WhileRangeValue a = readDataOperand(instr, 1, input);
-        WhileRangeValue b = readDataOperand(instr, 2, input);
+        WhileRangeValue a = readDataOperand(instr, 1, value);
+        WhileRangeValue b = readDataOperand(instr, 2, value);
 
         if (a.Kind == CONSTANT && b.Kind == CONSTANT)
-          updateRegisterOperand(instr, 0, result, a == b);
+          updateRegisterOperand(instr, 0, value, a == b);
         else
-          updateRegisterOperand(instr, 0, result, BOTTOM);
+          updateRegisterOperand(instr, 0, value, BOTTOM);
         break;
       }
       case WUNEQUAL:
       {
         // Ops: OpD = OpA != OpB
         assert(ops.size() ==  3);
-        WhileRangeValue a = readDataOperand(instr, 1, input);
-        WhileRangeValue b = readDataOperand(instr, 2, input);
+        WhileRangeValue a = readDataOperand(instr, 1, value);
+        WhileRangeValue b = readDataOperand(instr, 2, value);
 
         if (a.Kind == CONSTANT && b.Kind == CONSTANT)
-          updateRegisterOperand(instr, 0, result, a != b);
+          updateRegisterOperand(instr, 0, value, a != b);
         else
-          updateRegisterOperand(instr, 0, result, BOTTOM);
+          updateRegisterOperand(instr, 0, value, BOTTOM);
         break;
       }
       case WLESS:
       {
         // Ops: OpD = OpA < OpB
         assert(ops.size() ==  3);
-        WhileRangeValue a = readDataOperand(instr, 1, input);
-        WhileRangeValue b = readDataOperand(instr, 2, input);
+        WhileRangeValue a = readDataOperand(instr, 1, value);
+        WhileRangeValue b = readDataOperand(instr, 2, value);
 
         if (a.Kind == CONSTANT && b.Kind == CONSTANT)
-          updateRegisterOperand(instr, 0, result, a < b);
+          updateRegisterOperand(instr, 0, value, a < b);
         else
-          updateRegisterOperand(instr, 0, result, BOTTOM);
+          updateRegisterOperand(instr, 0, value, BOTTOM);
         break;
       }
       case WLESSEQUAL:
       {
         // Ops: OpD = OpA <= OpB
         assert(ops.size() ==  3);
-        WhileRangeValue a = readDataOperand(instr, 1, input);
-        WhileRangeValue b = readDataOperand(instr, 2, input);
+        WhileRangeValue a = readDataOperand(instr, 1, value);
+        WhileRangeValue b = readDataOperand(instr, 2, value);
 
         if (a.Kind == CONSTANT && b.Kind == CONSTANT)
-          updateRegisterOperand(instr, 0, result, a <= b);
+          updateRegisterOperand(instr, 0, value, a <= b);
         else
-          updateRegisterOperand(instr, 0, result, BOTTOM);
+          updateRegisterOperand(instr, 0, value, BOTTOM);
         break;
       }
     };
+  }
 
-    return result;
+  // Smallest threshold at or above v, and largest one at or below v.
+  int above(int v) const
+  {
+    const auto t = Thresholds.lower_bound(v);
+    return t == Thresholds.end() ? INT_MAX : *t;
+  }
+
+  int below(int v) const
+  {
+    auto t = Thresholds.upper_bound(v);
+    return t == Thresholds.begin() ? INT_MIN : *--t;
+  }
+
+  // Bounds that grew since the previous visit of a loop head are moved to the
+  // next threshold.
+  void widen(WhileConstantDomain &value,
+             const WhileConstantDomain &previous) override
+  {
+    for(unsigned int idx = 0; idx < value.size(); idx++)
+    {
+      WhileRangeValue &v = value[idx];
+      const WhileRangeValue &p = previous[idx];
+      if (v.Kind != CONSTANT || p.Kind != CONSTANT)
+        continue;
+
+      v.lowerValue = v.lowerValue < p.lowerValue ? below(v.lowerValue)
+                                                 : p.lowerValue;
+      v.upperValue = v.upperValue > p.upperValue ? above(v.upperValue)
+                                                 : p.upperValue;
+    }
+  }
+
+  // Intersect the widened ranges with the ranges of the descending pass.
+  void narrow(WhileConstantDomain &value,
+              const WhileConstantDomain &previous) override
+  {
+    for(unsigned int idx = 0; idx < value.size(); idx++)
+    {
+      WhileRangeValue &v = value[idx];
+      const WhileRangeValue &p = previous[idx];
+      if (v.Kind != CONSTANT || p.Kind != CONSTANT)
+        continue;
+
+      int min = std::max(v.lowerValue, p.lowerValue);
+      int max = std::min(v.upperValue, p.upperValue);
+      if (min <= max)
+        v = WhileRangeValue{CONSTANT, min, max};
+    }
   }
 
   static WhileRangeValue join(const WhileRangeValue &a,
@@ -380,30 +464,49 @@ struct WhileConstant : public WhileDataFlowAnalysis<WhileConstantDomain>
       return BOTTOM;
   }
 
-  WhileConstantDomain join(std::list<WhileConstantDomain> inputs) override
+  void joinInto(WhileConstantDomain &result,
+                const WhileConstantDomain &input) override
   {
-    WhileConstantDomain result;
-    for(WhileConstantDomain r : inputs)
+    for(unsigned int idx = 0; idx < input.size(); idx++)
     {
-      for(const auto&[idx, value] : r)
-      {
-        WhileRangeValue &resultvalue = result[idx];
-        resultvalue = join(resultvalue, value);
-      }
-    }
+      if (!input.contains(idx))
+        continue;
 
-    return result;
+      WhileRangeValue &resultvalue = result[idx];
+      resultvalue = join(resultvalue, input[idx]);
+    }
   }
 };
 
 
 struct WhileValueRangeAnalysis : public WhileAnalysis
 {
-  void analyze(const WhileProgram &p) override
+  void analyze(const WhileProgram &p, std::ostream &s) override
   {
     WhileConstant WCRA;
-    WCRA.analyze(p);
-    WCRA.dump(std::cout, p);
+
+    WCRA.Thresholds = WideningThresholds;
+    if (HarvestThresholds)
+    {
+      for(const WhileFunction *f : p.FunctionsByIndex)
+      {
+        for(const WhileBlock &bb : f->Body)
+        {
+          for(const WhileInstr &i : bb.Body)
+          {
+            for(const WhileOperand &op : i.Ops)
+            {
+              if (op.Kind == WIMMEDIATE)
+                WCRA.Thresholds.emplace(op.ValueOrIndex);
+            }
+          }
+        }
+      }
+    }
+
+    analyzeParallel(WCRA, p, Threads);
+    Stats = WCRA.Stats;
+    WCRA.dump(s, p);
   };
 
   WhileValueRangeAnalysis() : WhileAnalysis("WVRA",
@@ -0,0 +1,238 @@
+#!/bin/sh
+# This file is part of While, an educational programming language and program
+# analysis framework.
+#
+#   Copyright 2023 Florian Brandner
+#
+# While is free software: you can redistribute it and/or modify it under the
+# terms of the GNU General Public License as published by the Free Software
+# Foundation, either version 3 of the License, or (at your option) any later
+# version.
+#
+# While is distributed in the hope that it will be useful, but WITHOUT ANY
+# WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+# A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License along with
+# While. If not, see <https://www.gnu.org/licenses/>.
+#
+# Contact: florian.brandner@telecom-paris.fr
+#
+
+# This script runs a single test, see CMakeLists.txt in this directory:
+#
+#   run-test.sh expect <file> <command>...
+#     The result of the command, i.e., its output, the messages it prints to
+#     stderr, and its exit code, has to match the file. With WHILE_UPDATE=1
+#     in the environment, the file is written instead.
+#
+#   run-test.sh same <command>... -- <command>...
+#     Both commands have to produce the same result.
+#
+#   run-test.sh modes <tools> <file> <argument>...
+#     Running while-run with the arguments has to give the result in the file
+#     in every execution mode.
+#
+#   run-test.sh roundtrip <tools> <input.whl> [dump]
+#     The input compiled by while-compile has to dump and run exactly like the
+#     input itself. With dump, the programs are not run, e.g., if they do not
+#     terminate.
+#
+#   run-test.sh cache <tools> <input.whl> <analysis>...
+#     Analyzing the input has to give the same result without the cache, when
+#     filling the cache, and when loading the results from the cache.
+#
+#   run-test.sh corrupt <tools> <input.whl> <function>
+#     Damaged compiled programs have to be rejected with an error. The function
+#     has to be called by main, and its name must not occur before it in the
+#     compiled program, e.g., as a variable name.
+
+set -u
+
+# Print the result of running the command given as arguments.
+result()
+{
+  "$@" > "$tmp/stdout" 2> "$tmp/stderr" < /dev/null
+  code=$?
+  cat "$tmp/stdout"
+  echo "--- stderr"
+  cat "$tmp/stderr"
+  echo "--- exit code $code"
+}
+
+# Compare the result of the command following the first argument to the file
+# given as first argument.
+expect()
+{
+  file=$1
+  shift
+  result "$@" > "$tmp/result"
+  if [ "${WHILE_UPDATE:-0}" = 1 ]; then
+    cp "$tmp/result" "$file"
+  elif ! diff -u "$file" "$tmp/result"; then
+    echo "FAIL: $*"
+    return 1
+  fi
+}
+
+# Compare the results of two commands, separated by --.
+same()
+{
+  first "$@" > "$tmp/first"
+  while [ "$1" != "--" ]; do
+    shift
+  done
+  shift
+
+  result "$@" > "$tmp/second"
+  if ! diff -u "$tmp/first" "$tmp/second"; then
+    echo "FAIL: results differ"
+    return 1
+  fi
+}
+
+# Print the result of the command preceding -- in the arguments.
+first()
+{
+  keep=1
+  for arg; do
+    shift
+    [ "$arg" = "--" ] && keep=0
+    [ $keep = 1 ] && set -- "$@" "$arg"
+  done
+  result "$@"
+}
+
+modes()
+{
+  tools=$1
+  file=$2
+  shift 2
+  for mode in cfg bytecode threaded; do
+    expect "$file" "$tools/while-run" -m $mode "$@" || return 1
+  done
+}
+
+roundtrip()
+{
+  tools=$1
+  input=$2
+  "$tools/while-compile" -o "$tmp/p.wcfg" "$input" || return 1
+
+  same "$tools/while-analysis" --no-cache -d "$input" -- \
+       "$tools/while-analysis" --no-cache -d "$tmp/p.wcfg" || return 1
+  [ "${3:-}" = "dump" ] ||
+    same "$tools/while-run" "$input" -- "$tools/while-run" "$tmp/p.wcfg"
+}
+
+cache()
+{
+  tools=$1
+  input=$2
+  shift 2
+  WHILE_CACHE_DIR="$tmp/cache"
+  export WHILE_CACHE_DIR
+
+  result "$tools/while-analysis" --no-cache -s "$@" "$input" > "$tmp/first"
+  for run in miss hit; do
+    result "$tools/while-analysis" -s "$@" "$input" > "$tmp/second"
+    if ! diff -u "$tmp/first" "$tmp/second"; then
+      echo "FAIL: cache $run differs"
+      return 1
+    fi
+
+    if [ -z "$(ls "$tmp/cache")" ]; then
+      echo "FAIL: cache is empty"
+      return 1
+    fi
+  done
+}
+
+# Print the 32-bit word of the compiled program at the offset.
+word()
+{
+  od -An -tu4 -j $1 -N 4 "$tmp/p.wcfg" | tr -d ' '
+}
+
+# Overwrite the bytes of the file at the offset by the string.
+patch()
+{
+  cp "$tmp/p.wcfg" "$tmp/bad.wcfg"
+  printf "$2" | dd of="$tmp/bad.wcfg" bs=1 seek=$1 conv=notrunc 2> /dev/null
+}
+
+# The command given as arguments has to fail with a message.
+rejects()
+{
+  if "$@" > /dev/null 2> "$tmp/stderr" < /dev/null; then
+    echo "FAIL: accepted: $*"
+    return 1
+  fi
+
+  if [ ! -s "$tmp/stderr" ]; then
+    echo "FAIL: no error message: $*"
+    return 1
+  fi
+}
+
+corrupt()
+{
+  tools=$1
+  input=$2
+  "$tools/while-compile" -o "$tmp/p.wcfg" "$input" || return 1
+  size=$(wc -c < "$tmp/p.wcfg")
+
+  # truncated after the header, and in the middle of the code.
+  for keep in 8 32 $((size / 2)) $((size - 1)); do
+    dd if="$tmp/p.wcfg" of="$tmp/bad.wcfg" bs=1 count=$keep 2> /dev/null
+    rejects "$tools/while-run" "$tmp/bad.wcfg" || return 1
+    rejects "$tools/while-analysis" WDCA "$tmp/bad.wcfg" || return 1
+  done
+
+  # another version of the format.
+  patch 4 '\377'
+  rejects "$tools/while-run" "$tmp/bad.wcfg" || return 1
+
+  # the frame size, the number of registers, the maximal number of call
+  # arguments, and the number of parameters of the function follow its name.
+  # The values are the same in either byte order.
+  name=$(grep -abo "$3" "$tmp/p.wcfg" | head -n 1 | cut -d : -f 1)
+  fields=$((name + ${#3}))
+  for value in '\377\377\377\377' '\100\100\100\100'; do
+    for field in 0 4 8 12; do
+      patch $((fields + field)) "$value"
+      rejects "$tools/while-run" "$tmp/bad.wcfg" || return 1
+    done
+  done
+
+  # the first two instructions of the function with the same Id. They follow
+  # the sizes of its arrays, its variables, and its blocks.
+  pos=$((fields + 32))
+  pos=$((pos + 4 + 4 * $(word $pos)))
+  pos=$((pos + 4 + 12 * $(word $pos)))
+  pos=$(((pos + 7) / 8 * 8 + $(word $((fields + 16))) * $(word 8)))
+  id=$(((pos + 7) / 8 * 8 + 4))
+  cp "$tmp/p.wcfg" "$tmp/bad.wcfg"
+  dd if="$tmp/p.wcfg" of="$tmp/bad.wcfg" bs=1 skip=$id \
+     seek=$((id + $(word 12))) count=4 conv=notrunc 2> /dev/null
+  rejects "$tools/while-run" "$tmp/bad.wcfg" || return 1
+  rejects "$tools/while-analysis" WDCA "$tmp/bad.wcfg" || return 1
+
+  # a frame that does not fit into the stack, but is not rejected as corrupt.
+  patch $fields '\177\177\177\177'
+  for mode in cfg bytecode threaded; do
+    "$tools/while-run" -m $mode "$tmp/bad.wcfg" > /dev/null 2> "$tmp/stderr"
+    if [ $? != 4 ] || ! grep -q "^runtime error: .*stack overflow" "$tmp/stderr"
+    then
+      echo "FAIL: no stack overflow in mode $mode"
+      return 1
+    fi
+  done
+}
+
+tmp=$(mktemp -d) || exit 1
+trap 'rm -rf "$tmp"' EXIT
+
+check=$1
+shift
+"$check" "$@"